@@ -0,0 +1,169 @@
+#ifndef INDEXED_HEAP_HPP_INCLUDED
+#define INDEXED_HEAP_HPP_INCLUDED
+
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+
+template<typename Key, typename Priority, typename Hash = std::hash<Key>>
+class indexed_heap {
+  public:
+    using value_type = std::pair<Priority, Key>;
+
+
+
+    [[nodiscard]] bool   empty() const { return heap_.empty(); }
+    [[nodiscard]] size_t size()  const { return heap_.size();  }
+
+    [[nodiscard]] bool contains(const Key& key) const { return index_.contains(key); }
+
+
+
+    [[nodiscard]] std::optional<Priority> priority(const Key& key) const {
+      if (auto it = index_.find(key); it != index_.end()) {
+        return heap_[it->second].first;
+      }
+      return {};
+    }
+
+
+
+    [[nodiscard]] const value_type& top() const { return heap_.front(); }
+
+
+
+    // inserts key or changes its priority, returns false if nothing changed
+    bool set(const Key& key, Priority priority) {
+      if (auto it = index_.find(key); it != index_.end()) {
+        auto pos = it->second;
+
+        if (heap_[pos].first == priority) {
+          return false;
+        }
+
+        bool decrease = priority < heap_[pos].first;
+        heap_[pos].first = std::move(priority);
+
+        if (decrease) {
+          sift_up(pos);
+        } else {
+          sift_down(pos);
+        }
+        return true;
+      }
+
+      index_.emplace(key, heap_.size());
+      heap_.emplace_back(std::move(priority), key);
+      sift_up(heap_.size() - 1);
+
+      return true;
+    }
+
+
+
+    bool erase(const Key& key) {
+      auto it = index_.find(key);
+      if (it == index_.end()) {
+        return false;
+      }
+
+      auto pos = it->second;
+      index_.erase(it);
+
+      if (pos + 1 == heap_.size()) {
+        heap_.pop_back();
+        return true;
+      }
+
+      heap_[pos] = std::move(heap_.back());
+      heap_.pop_back();
+      index_[heap_[pos].second] = pos;
+
+      if (pos > 0 && heap_[pos].first < heap_[parent(pos)].first) {
+        sift_up(pos);
+      } else {
+        sift_down(pos);
+      }
+
+      return true;
+    }
+
+
+
+    value_type pop() {
+      value_type out = std::move(heap_.front());
+      index_.erase(out.second);
+
+      if (heap_.size() > 1) {
+        heap_.front() = std::move(heap_.back());
+        heap_.pop_back();
+        index_[heap_.front().second] = 0;
+        sift_down(0);
+      } else {
+        heap_.pop_back();
+      }
+
+      return out;
+    }
+
+
+
+    void clear() {
+      heap_.clear();
+      index_.clear();
+    }
+
+
+
+  private:
+    std::vector<value_type>                 heap_;
+    std::unordered_map<Key, size_t, Hash>   index_;
+
+
+
+    [[nodiscard]] static size_t parent(size_t pos) { return (pos - 1) / 2; }
+
+
+
+    void swap_nodes(size_t a, size_t b) {
+      std::swap(heap_[a], heap_[b]);
+      index_[heap_[a].second] = a;
+      index_[heap_[b].second] = b;
+    }
+
+
+
+    void sift_up(size_t pos) {
+      while (pos > 0 && heap_[pos].first < heap_[parent(pos)].first) {
+        swap_nodes(pos, parent(pos));
+        pos = parent(pos);
+      }
+    }
+
+
+
+    void sift_down(size_t pos) {
+      while (true) {
+        size_t smallest = pos;
+
+        for (size_t child = 2 * pos + 1; child <= 2 * pos + 2; ++child) {
+          if (child < heap_.size() && heap_[child].first < heap_[smallest].first) {
+            smallest = child;
+          }
+        }
+
+        if (smallest == pos) {
+          return;
+        }
+
+        swap_nodes(pos, smallest);
+        pos = smallest;
+      }
+    }
+};
+
+#endif // INDEXED_HEAP_HPP_INCLUDED
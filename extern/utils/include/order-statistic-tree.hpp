@@ -0,0 +1,257 @@
+#ifndef ORDER_STATISTIC_TREE_HPP_INCLUDED
+#define ORDER_STATISTIC_TREE_HPP_INCLUDED
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+
+// sequence with O(log n) (expected) access, insertion and removal by position,
+// implemented as a treap whose nodes know the size of their subtree
+template<typename T>
+class order_statistic_tree {
+  public:
+    order_statistic_tree() = default;
+
+    order_statistic_tree(const order_statistic_tree&) = delete;
+    order_statistic_tree(order_statistic_tree&&) noexcept = default;
+    order_statistic_tree& operator=(const order_statistic_tree&) = delete;
+    order_statistic_tree& operator=(order_statistic_tree&&) noexcept = default;
+
+    ~order_statistic_tree() { clear(); }
+
+
+
+    [[nodiscard]] bool   empty() const { return !root_; }
+    [[nodiscard]] size_t size()  const { return size_of(root_); }
+
+
+
+    [[nodiscard]] const T& operator[](size_t index) const { return at(root_, index); }
+    [[nodiscard]]       T& operator[](size_t index)       { return at(root_, index); }
+
+
+
+    // number of leading elements satisfying pred, which must partition the sequence
+    template<typename Pred>
+    [[nodiscard]] size_t partition_point(Pred&& pred) const {
+      size_t offset{0};
+
+      for (const auto* n = root_.get(); n != nullptr;) {
+        if (pred(n->value)) {
+          offset += size_of(n->left) + 1;
+          n = n->right.get();
+        } else {
+          n = n->left.get();
+        }
+      }
+
+      return offset;
+    }
+
+
+
+    template<typename Fnc>
+    void for_each(Fnc&& fnc) const {
+      auto visit = [&fnc](const T& value) { fnc(value); };
+      in_order(root_, visit);
+    }
+
+
+
+    void insert(size_t index, T value) {
+      auto [left, right] = split(std::move(root_), index);
+      auto n = std::make_unique<node>(std::move(value), next_priority());
+      root_ = merge(merge(std::move(left), std::move(n)), std::move(right));
+    }
+
+
+
+    T erase(size_t index) {
+      auto [left, rest]     = split(std::move(root_), index);
+      auto [removed, right] = split(std::move(rest), 1);
+      root_ = merge(std::move(left), std::move(right));
+
+      return std::move(removed->value);
+    }
+
+
+
+    // replaces the content in O(n)
+    void assign(std::vector<T> values) {
+      clear();
+
+      // builds the cartesian tree of the priorities; the right spine is kept on a stack
+      std::vector<std::unique_ptr<node>> spine;
+
+      for (auto& value: values) {
+        auto n = std::make_unique<node>(std::move(value), next_priority());
+
+        std::unique_ptr<node> last;
+        while (!spine.empty() && spine.back()->priority < n->priority) {
+          if (last) {
+            spine.back()->right = std::move(last);
+            update(*spine.back());
+          }
+          last = std::move(spine.back());
+          spine.pop_back();
+        }
+
+        n->left = std::move(last);
+        update(*n);
+        spine.emplace_back(std::move(n));
+      }
+
+      while (spine.size() > 1) {
+        auto last = std::move(spine.back());
+        spine.pop_back();
+        spine.back()->right = std::move(last);
+        update(*spine.back());
+      }
+
+      if (!spine.empty()) {
+        root_ = std::move(spine.front());
+      }
+    }
+
+
+
+    // moves all elements out in order, leaving the tree empty
+    [[nodiscard]] std::vector<T> release() {
+      std::vector<T> values;
+      values.reserve(size());
+
+      auto take = [&values](T& value) { values.emplace_back(std::move(value)); };
+      in_order(root_, take);
+      clear();
+
+      return values;
+    }
+
+
+
+    void clear() {
+      // iteratively, the tree may be deep in the worst case
+      std::vector<std::unique_ptr<node>> pending;
+      if (root_) {
+        pending.emplace_back(std::move(root_));
+      }
+
+      while (!pending.empty()) {
+        auto n = std::move(pending.back());
+        pending.pop_back();
+
+        if (n->left)  { pending.emplace_back(std::move(n->left));  }
+        if (n->right) { pending.emplace_back(std::move(n->right)); }
+      }
+    }
+
+
+
+  private:
+    struct node {
+      node(T v, uint64_t p) : value{std::move(v)}, priority{p} {}
+
+      T                     value;
+      uint64_t              priority;
+      size_t                size{1};
+      std::unique_ptr<node> left;
+      std::unique_ptr<node> right;
+    };
+
+    using node_ptr = std::unique_ptr<node>;
+
+    node_ptr root_;
+    uint64_t seed_{0x9e3779b97f4a7c15};
+
+
+
+    [[nodiscard]] uint64_t next_priority() {
+      // splitmix64
+      uint64_t z = (seed_ += 0x9e3779b97f4a7c15);
+      z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27U)) * 0x94d049bb133111eb;
+      return z ^ (z >> 31U);
+    }
+
+
+
+    [[nodiscard]] static size_t size_of(const node_ptr& n) { return n ? n->size : 0; }
+
+    static void update(node& n) {
+      n.size = size_of(n.left) + size_of(n.right) + 1;
+    }
+
+
+
+    template<typename Ptr>
+    [[nodiscard]] static auto& at(Ptr& root, size_t index) {
+      auto* n = root.get();
+
+      while (true) {
+        auto left = size_of(n->left);
+
+        if (index < left) {
+          n = n->left.get();
+        } else if (index == left) {
+          return n->value;
+        } else {
+          index -= left + 1;
+          n = n->right.get();
+        }
+      }
+    }
+
+
+
+    template<typename Ptr, typename Fnc>
+    static void in_order(Ptr& n, Fnc& fnc) {
+      if (n) {
+        in_order(n->left, fnc);
+        fnc(n->value);
+        in_order(n->right, fnc);
+      }
+    }
+
+
+
+    // first count elements and the rest
+    [[nodiscard]] static std::pair<node_ptr, node_ptr> split(node_ptr n, size_t count) {
+      if (!n) {
+        return {};
+      }
+
+      if (count <= size_of(n->left)) {
+        auto [left, right] = split(std::move(n->left), count);
+        n->left = std::move(right);
+        update(*n);
+        return {std::move(left), std::move(n)};
+      }
+
+      auto [left, right] = split(std::move(n->right), count - size_of(n->left) - 1);
+      n->right = std::move(left);
+      update(*n);
+      return {std::move(n), std::move(right)};
+    }
+
+
+
+    [[nodiscard]] static node_ptr merge(node_ptr left, node_ptr right) {
+      if (!left)  { return right; }
+      if (!right) { return left;  }
+
+      if (left->priority > right->priority) {
+        left->right = merge(std::move(left->right), std::move(right));
+        update(*left);
+        return left;
+      }
+
+      right->left = merge(std::move(left), std::move(right->left));
+      update(*right);
+      return right;
+    }
+};
+
+#endif // ORDER_STATISTIC_TREE_HPP_INCLUDED
@@ -36,6 +36,10 @@ class application : public window_listener, public viewport {
     [[nodiscard]] const window_native& window() const { return *native_; }
     [[nodiscard]]       window_native& window()       { return *native_; }
 
+    [[nodiscard]] const frame_statistics& frame_stats() const {
+      return native_->frame_stats();
+    }
+
 
 
   private:
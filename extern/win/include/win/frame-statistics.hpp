@@ -0,0 +1,94 @@
+#ifndef WIN_FRAME_STATISTICS_HPP_INCLUDED
+#define WIN_FRAME_STATISTICS_HPP_INCLUDED
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+
+
+namespace win {
+
+class frame_statistics {
+  public:
+    using clock    = std::chrono::steady_clock;
+    using duration = clock::duration;
+
+
+
+    class histogram {
+      public:
+        static constexpr duration bucket_width{std::chrono::microseconds{250}};
+        static constexpr size_t   bucket_count{256};
+
+        void add(duration);
+
+        [[nodiscard]] uint64_t count() const { return count_; }
+        [[nodiscard]] duration last()  const { return last_;  }
+        [[nodiscard]] duration max()   const { return max_;   }
+        [[nodiscard]] duration mean()  const;
+
+        // upper bound of the bucket containing the percentile (in [0, 1]),
+        // everything above the last bucket is reported as the maximum
+        [[nodiscard]] duration percentile(float) const;
+
+
+
+      private:
+        std::array<uint64_t, bucket_count + 1> buckets_{};
+        uint64_t                               count_{0};
+        duration                               total_{0};
+        duration                               max_  {0};
+        duration                               last_ {0};
+    };
+
+
+
+    enum class stage {
+      update,
+      render,
+      swap,
+      // between frame callbacks (or presented frames) with a frame rendered in between
+      interval,
+    };
+
+
+
+    [[nodiscard]] const histogram& operator[](stage s) const {
+      return histograms_[static_cast<size_t>(s)];
+    }
+
+    void frame(duration update, duration render, duration swap);
+
+    // marks the start of a new refresh cycle
+    void frame_callback(clock::time_point = clock::now());
+
+
+
+    // frames whose update and render take longer than this are counted as missed
+    void budget(duration budget) { budget_ = budget; }
+    [[nodiscard]] duration budget() const { return budget_; }
+
+    [[nodiscard]] uint64_t missed_frames() const { return missed_frames_; }
+
+
+
+    // prints a summary at verbose level
+    void log() const;
+
+
+
+  private:
+    std::array<histogram, 4>         histograms_;
+
+    duration                         budget_{std::chrono::microseconds{1'000'000 / 60}};
+    uint64_t                         missed_frames_{0};
+
+    std::optional<clock::time_point> last_callback_;
+    bool                             rendered_since_callback_{false};
+};
+
+}
+
+#endif // WIN_FRAME_STATISTICS_HPP_INCLUDED
@@ -0,0 +1,35 @@
+#ifndef WIN_HEADLESS_EGL_HPP_INCLUDED
+#define WIN_HEADLESS_EGL_HPP_INCLUDED
+
+#include "win/context-wayland.hpp"
+
+#include <EGL/egl.h>
+
+
+
+namespace win {
+
+// egl without any window system (EGL_MESA_platform_surfaceless), contexts have no
+// default framebuffer and can only render into framebuffer objects
+class headless_egl {
+  public:
+    headless_egl(const headless_egl&) = delete;
+    headless_egl(headless_egl&&)      = delete;
+    headless_egl& operator=(const headless_egl&) = delete;
+    headless_egl& operator=(headless_egl&&)      = delete;
+
+    headless_egl();
+    ~headless_egl();
+
+    [[nodiscard]] context_wayland create_context()                       const;
+    [[nodiscard]] context_wayland create_context(const context_wayland&) const;
+
+
+
+  private:
+    EGLDisplay display_{EGL_NO_DISPLAY};
+};
+
+}
+
+#endif // WIN_HEADLESS_EGL_HPP_INCLUDED
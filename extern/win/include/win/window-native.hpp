@@ -2,6 +2,7 @@
 #define WIN_WINDOW_NATIVE_HPP_INCLUDED
 
 #include "win/context.hpp"
+#include "win/frame-statistics.hpp"
 #include "win/modifier.hpp"
 
 #include <cstdint>
@@ -73,7 +74,13 @@ class window_native {
 
 
 
+    [[nodiscard]] const frame_statistics& frame_stats() const { return frame_stats_; }
+
+
+
   protected:
+    frame_statistics frame_stats_;
+
     [[nodiscard]] bool update();
 
     virtual void on_new_parent() {}
@@ -0,0 +1,109 @@
+#include "win/frame-statistics.hpp"
+
+#include <algorithm>
+
+#include <logcerr/log.hpp>
+
+
+
+void win::frame_statistics::histogram::add(duration value) {
+  auto bucket = std::min<size_t>(std::max<int64_t>(value / bucket_width, 0), bucket_count);
+  buckets_[bucket]++;
+
+  count_++;
+  total_ += value;
+  max_    = std::max(max_, value);
+  last_   = value;
+}
+
+
+
+win::frame_statistics::duration win::frame_statistics::histogram::mean() const {
+  if (count_ == 0) {
+    return duration{0};
+  }
+  return total_ / count_;
+}
+
+
+
+win::frame_statistics::duration win::frame_statistics::histogram::percentile(
+    float p
+) const {
+  auto target = static_cast<uint64_t>(std::clamp(p, 0.f, 1.f) *
+                                      static_cast<float>(count_));
+
+  uint64_t seen{0};
+  for (size_t i = 0; i < bucket_count; ++i) {
+    seen += buckets_[i];
+    if (seen > target) {
+      return std::min<duration>(max_, bucket_width * (i + 1));
+    }
+  }
+
+  return max_;
+}
+
+
+
+
+
+void win::frame_statistics::frame(duration update, duration render, duration swap) {
+  histograms_[static_cast<size_t>(stage::update)].add(update);
+  histograms_[static_cast<size_t>(stage::render)].add(render);
+  histograms_[static_cast<size_t>(stage::swap)]  .add(swap);
+
+  if (update + render > budget_) {
+    missed_frames_++;
+  }
+
+  rendered_since_callback_ = true;
+}
+
+
+
+void win::frame_statistics::frame_callback(clock::time_point now) {
+  // without a frame in between, the time since the last callback was idle
+  if (last_callback_ && rendered_since_callback_) {
+    histograms_[static_cast<size_t>(stage::interval)].add(now - *last_callback_);
+  }
+
+  last_callback_           = now;
+  rendered_since_callback_ = false;
+}
+
+
+
+
+
+namespace {
+  [[nodiscard]] float ms(win::frame_statistics::duration value) {
+    return std::chrono::duration<float, std::milli>(value).count();
+  }
+
+
+
+  void log_histogram(const char* name, const win::frame_statistics::histogram& hist) {
+    logcerr::verbose("{:>8}: mean {:.2f} ms, p50 {:.2f} ms, p95 {:.2f} ms, "
+        "p99 {:.2f} ms, max {:.2f} ms", name, ms(hist.mean()), ms(hist.percentile(0.5f)),
+        ms(hist.percentile(0.95f)), ms(hist.percentile(0.99f)), ms(hist.max()));
+  }
+}
+
+
+
+void win::frame_statistics::log() const {
+  const auto& frames = (*this)[stage::render];
+
+  if (frames.count() == 0) {
+    return;
+  }
+
+  logcerr::verbose("rendered {} frame(s), {} exceeded the budget of {:.2f} ms",
+      frames.count(), missed_frames_, ms(budget_));
+
+  log_histogram("update",   (*this)[stage::update]);
+  log_histogram("render",   (*this)[stage::render]);
+  log_histogram("swap",     (*this)[stage::swap]);
+  log_histogram("interval", (*this)[stage::interval]);
+}
@@ -8,10 +8,12 @@
 
 
 namespace {
-  constexpr std::array<EGLint, 6> context = {
-    EGL_CONTEXT_MAJOR_VERSION, 3,
-    EGL_CONTEXT_MINOR_VERSION, 2,
-    EGL_NONE,                  EGL_NONE,
+  // persistently mapped buffers (glBufferStorage) require 4.4, the shaders 4.5
+  constexpr std::array<EGLint, 8> context = {
+    EGL_CONTEXT_MAJOR_VERSION,       4,
+    EGL_CONTEXT_MINOR_VERSION,       5,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE,                        EGL_NONE,
   };
 
   constexpr std::array<EGLint, 14> attributes = {
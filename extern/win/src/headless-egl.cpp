@@ -0,0 +1,83 @@
+#include "win/headless-egl.hpp"
+
+#include <array>
+#include <stdexcept>
+
+#include <EGL/eglext.h>
+
+
+
+namespace {
+  // persistently mapped buffers (glBufferStorage) require 4.4, the shaders 4.5
+  constexpr std::array<EGLint, 8> context = {
+    EGL_CONTEXT_MAJOR_VERSION,       4,
+    EGL_CONTEXT_MINOR_VERSION,       5,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE,                        EGL_NONE,
+  };
+
+
+
+  [[nodiscard]] EGLDisplay create_display() {
+    EGLDisplay display = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                               EGL_DEFAULT_DISPLAY, nullptr);
+
+    if (display == EGL_NO_DISPLAY) {
+      throw std::runtime_error{"unable to obtain surfaceless egl display"};
+    }
+
+    if (eglInitialize(display, nullptr, nullptr) == EGL_FALSE) {
+      throw std::runtime_error{"unable to initialize egl"};
+    }
+
+    if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE) {
+      throw std::runtime_error{"unable to bind egl api"};
+    }
+
+    return display;
+  }
+
+
+
+  [[nodiscard]] EGLContext create_context(EGLDisplay display, EGLContext shared) {
+    // without a surface, no config is required (EGL_KHR_no_config_context)
+    EGLContext ctx = eglCreateContext(display, EGL_NO_CONFIG_KHR, shared, context.data());
+    if (ctx == EGL_NO_CONTEXT) {
+      throw std::runtime_error{"unable to create context"};
+    }
+    return ctx;
+  }
+}
+
+
+
+win::headless_egl::headless_egl() :
+  display_{create_display()}
+{}
+
+
+
+win::headless_egl::~headless_egl() {
+  // contexts still current on other threads are destroyed once released
+  eglTerminate(display_);
+}
+
+
+
+win::context_wayland win::headless_egl::create_context() const {
+  return context_wayland{
+      ::create_context(display_, EGL_NO_CONTEXT),
+      EGL_NO_SURFACE,
+      display_
+  };
+}
+
+
+
+win::context_wayland win::headless_egl::create_context(const context_wayland& ctx) const {
+  return context_wayland{
+      ::create_context(display_, ctx.get()),
+      EGL_NO_SURFACE,
+      display_
+  };
+}
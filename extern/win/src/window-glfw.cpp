@@ -57,6 +57,11 @@ win::window_glfw::window_glfw(const std::string& app_id) {
   glfwMakeContextCurrent(window_);
 
   glfwSwapInterval(1);
+
+  if (const auto* mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+      mode != nullptr && mode->refreshRate > 0) {
+    frame_stats_.budget(std::chrono::microseconds{1'000'000 / mode->refreshRate});
+  }
 }
 
 
@@ -99,10 +104,22 @@ void win::window_glfw::run() {
   rescale(size_, scale_);
 
   while (glfwWindowShouldClose(window_) == GLFW_FALSE) {
+    auto start = frame_statistics::clock::now();
+
     if (update()) {
+      auto updated_at = frame_statistics::clock::now();
       parent()->render();
+
+      auto rendered_at = frame_statistics::clock::now();
+      // blocks until the next refresh, which stands in for a frame callback
       glfwSwapBuffers(window_);
+
+      auto swapped_at = frame_statistics::clock::now();
+      frame_stats_.frame(updated_at - start, rendered_at - updated_at,
+          swapped_at - rendered_at);
+      frame_stats_.frame_callback(swapped_at);
     } else {
+      frame_stats_.frame_callback();
       std::this_thread::sleep_for(std::chrono::milliseconds(1000 / 60));
     }
     glfwPollEvents();
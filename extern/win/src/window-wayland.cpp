@@ -195,6 +195,7 @@ void win::window_wayland::callback_done(
   auto* self = static_cast<window_wayland*>(data);
 
   self->frame_requested_ = true;
+  self->frame_stats_.frame_callback();
 
   self->callback_.reset(wl_surface_frame(self->surface_.get()));
   if (!self->callback_) {
@@ -307,10 +308,19 @@ void win::window_wayland::update_viewport() {
 
 
 void win::window_wayland::render(bool force) {
-  if (update() || force) {
+  auto start   = frame_statistics::clock::now();
+  bool updated = update();
+
+  if (updated || force) {
+    auto updated_at = frame_statistics::clock::now();
     parent()->render();
+
+    auto rendered_at = frame_statistics::clock::now();
     context_.swap_buffers();
 
+    frame_stats_.frame(updated_at - start, rendered_at - updated_at,
+        frame_statistics::clock::now() - rendered_at);
+
     frame_requested_ = false;
   }
 }
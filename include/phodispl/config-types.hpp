@@ -25,4 +25,11 @@ enum class listing_mode {
 };
 
 
+
+enum class watch_granularity {
+  files,
+  directories,
+};
+
+
 #endif // PHODISPL_CONFIG_TYPES_HPP_INCLUDED
@@ -24,10 +24,11 @@ struct config {
 
 
 
-    scale_filter filter     {scale_filter::linear};
-    bool         watch_fs   {true};
-    float        gamma      {2.2f};
-    float        input_speed{1.f};
+    scale_filter      filter              {scale_filter::linear};
+    bool              watch_fs            {true};
+    watch_granularity watch_fs_granularity{watch_granularity::directories};
+    float             gamma               {2.2f};
+    float             input_speed         {1.f};
 
 
 
@@ -59,6 +60,15 @@ struct config {
     uint32_t cache_load_backward{1};
     uint32_t cache_keep_forward{3};
     uint32_t cache_load_forward{2};
+    uint32_t cache_read_backward{2};
+    uint32_t cache_read_forward{6};
+    uint32_t cache_load_threads{0};
+    uint32_t cache_memory_budget{0};
+    uint32_t cache_texture_pool{256};
+
+    bool                      cache_disk_cache           {false};
+    uint32_t                  cache_disk_cache_size      {2048};
+    std::chrono::milliseconds cache_disk_cache_min_decode{100};
 
 
 
@@ -77,6 +87,10 @@ struct config {
 
     path_compare fl_compare_function      {path_compare_method::semantic};
 
+    uint32_t     fl_sniff_threads         {8};
+
+    std::chrono::milliseconds fl_watch_quiet{100};
+
 
 
     bool                      il_show_loading     {true};
@@ -87,12 +101,22 @@ struct config {
     bool                      il_partial_flush    {true};
     std::chrono::milliseconds il_partial_threshold{250};
     std::chrono::milliseconds il_partial_interval {20};
+
+    std::chrono::milliseconds il_dwell            {120};
+
+    uint32_t                  il_tile_threshold   {8192};
+    bool                      il_mipmaps          {true};
+
+    uint32_t                  il_map_threshold    {4};
 };
 
 
 
 [[nodiscard]] const config& global_config();
 
+// replaces the configuration, for tools adjusting single options
+void set_global_config(config);
+
 void load_config(const std::optional<std::filesystem::path>&, bool = false);
 
 #endif // PHODISPL_CONFIG_HPP_INCLUDED
@@ -0,0 +1,58 @@
+#ifndef PHODISPL_DISK_CACHE_HPP_INCLUDED
+#define PHODISPL_DISK_CACHE_HPP_INCLUDED
+
+#include "phodispl/pixel-source.hpp"
+
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+
+// directory of decoded images, shared between instances
+//
+// entries are written to temporary files and renamed, so readers only ever see
+// complete files; the modification time of an entry is its last use, entries used
+// least recently are removed once the directory exceeds the capacity
+class disk_cache {
+  public:
+    disk_cache(std::filesystem::path, size_t);
+
+
+
+    // identifies the decoded content of a file by its absolute path, size and
+    // modification time, and by the decoding options
+    [[nodiscard]] static std::optional<std::string> key_for(
+        const std::filesystem::path&,
+        std::string_view
+    );
+
+    // frames reference the mapped entry
+    [[nodiscard]] std::optional<std::vector<source_frame>> lookup(const std::string&);
+
+    void store(const std::string&, std::span<const source_frame>);
+
+
+
+  private:
+    std::filesystem::path directory_;
+    size_t                capacity_;
+    std::mutex            evict_mutex_;
+
+
+
+    [[nodiscard]] std::filesystem::path entry_path(const std::string&) const;
+
+    void evict();
+};
+
+
+
+// $XDG_CACHE_HOME/phodispl or ~/.cache/phodispl
+[[nodiscard]] std::optional<std::filesystem::path> default_disk_cache_directory();
+
+#endif // PHODISPL_DISK_CACHE_HPP_INCLUDED
@@ -0,0 +1,67 @@
+#ifndef PHODISPL_EVENT_COALESCER_HPP_INCLUDED
+#define PHODISPL_EVENT_COALESCER_HPP_INCLUDED
+
+#include "phodispl/fs-watcher.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+
+// merges the events of a path until it has been quiet for a while (e.g. added, changed,
+// changed while a file is being written) and delivers all settled paths in one batch
+class event_coalescer {
+  public:
+    using callback = std::move_only_function<void(std::vector<fs_watcher::event>)>;
+
+    event_coalescer(const event_coalescer&) = delete;
+    event_coalescer(event_coalescer&&)      = delete;
+    event_coalescer& operator=(const event_coalescer&) = delete;
+    event_coalescer& operator=(event_coalescer&&)      = delete;
+
+    ~event_coalescer() = default;
+
+    event_coalescer(callback, std::chrono::milliseconds);
+
+
+
+    void push(const std::filesystem::path&, fs_watcher::action);
+
+
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    struct pending_event {
+      // empty if the events cancelled each other out
+      std::optional<fs_watcher::action> action;
+      clock::time_point                 last;
+    };
+
+    callback                                                 callback_;
+    std::chrono::milliseconds                                quiet_period_;
+
+    std::mutex                                               mutex_;
+    std::condition_variable_any                              wakeup_;
+    std::unordered_map<std::filesystem::path, pending_event> pending_;
+    // paths in the order of their events; entries superseded by a later event of the
+    // same path are skipped
+    std::deque<std::pair<std::filesystem::path, clock::time_point>>
+                                                             arrivals_;
+
+    std::jthread                                             deliver_thread_;
+
+
+
+    void deliver_loop(const std::stop_token&);
+};
+
+#endif // PHODISPL_EVENT_COALESCER_HPP_INCLUDED
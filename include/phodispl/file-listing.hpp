@@ -5,15 +5,30 @@
 #define PHODISPL_FILE_LISTING_HPP_INCLUDED
 
 #include "phodispl/config-types.hpp"
+#include "phodispl/event-coalescer.hpp"
 #include "phodispl/fs-watcher.hpp"
 
 #include <filesystem>
+#include <functional>
+#include <mutex>
 #include <optional>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 
 
 class file_listing {
   public:
+    // receives listed files in the order they are discovered (not sorted)
+    using batch_callback =
+      std::move_only_function<void(std::vector<std::filesystem::path>)>;
+
+    // receives changes of listed files, collected over the quiet period of [file-listing]
+    using change_callback =
+      std::move_only_function<void(std::vector<fs_watcher::event>)>;
+
     file_listing(const file_listing&) = delete;
     file_listing(file_listing&&) = delete;
     file_listing& operator=(const file_listing&) = delete;
@@ -21,34 +36,73 @@ class file_listing {
 
     ~file_listing() = default;
 
-    explicit file_listing(fs_watcher::callback, std::vector<std::filesystem::path>);
+    explicit file_listing(change_callback, std::vector<std::filesystem::path>);
 
 
 
     [[nodiscard]] std::optional<std::filesystem::path> initial_file() const;
-    [[nodiscard]] std::vector<std::filesystem::path>   populate();
+    // lists all files, reporting them in batches while the listing is still running;
+    // stops early (without watching for changes) when a stop is requested
+    [[nodiscard]] std::vector<std::filesystem::path>   populate(
+        const std::stop_token& = {}, batch_callback = {});
 
     void clear();
 
     void demote_initial_file();
 
+    // no changes are reported afterwards; must not be called while populating
+    void stop_watching();
+
+    // compares the listing with the file system and reports the differences, for when
+    // events may have been missed
+    void rescan(const std::stop_token& = {});
+
 
 
 
 
   private:
     std::vector<std::filesystem::path>         initial_files_;
-    fs_watcher::callback                       callback_;
+    change_callback                            callback_;
 
     std::mutex                                 mutex_;
 
     std::vector<std::filesystem::path>         file_list_;
     std::vector<std::pair<listing_mode, bool>> mode_list_;
+    // position of every path in the lists
+    std::unordered_map<std::filesystem::path, size_t>
+                                               file_index_;
+    // indices into the lists whose codec still needs to be determined
+    std::vector<size_t>                        pending_sniffs_;
 
     std::optional<std::filesystem::path>       demotion_candidate_;
 
+    enum class listing_state {
+      // changes are dropped, the next population sees them anyway
+      unlisted,
+      // changes are deferred until the population has finished
+      populating,
+      listed
+    };
+
+    listing_state                              state_{listing_state::unlisted};
+    std::vector<fs_watcher::event>             deferred_events_;
+
+    // listed directories, which a rescan has to visit again
+    std::vector<std::filesystem::path>         directories_;
+    // the last time the file system was scanned, later modifications may be unreported
+    std::filesystem::file_time_type            scanned_at_;
+
+    // the watcher feeds the coalescer, which therefore has to outlive it
+    std::optional<event_coalescer>             coalescer_;
     std::optional<fs_watcher>                  fs_watcher_;
 
+    std::mutex                                 rescan_mutex_;
+    bool                                       rescanning_     {false};
+    bool                                       rescan_pending_ {false};
+    bool                                       rescans_stopped_{false};
+    std::jthread                               rescanner_;
+
 
 
     enum class startup_mode {
@@ -61,12 +115,30 @@ class file_listing {
     [[nodiscard]] startup_mode determine_startup_mode() const;
 
 
-    void on_file_changed(const std::filesystem::path&, fs_watcher::action);
+    void on_files_changed(std::vector<fs_watcher::event>);
+    void on_overflow();
+    [[nodiscard]] std::vector<fs_watcher::event> apply_changes_unsafe(
+        std::vector<fs_watcher::event>);
+    // the change to report for an event, if any
+    [[nodiscard]] std::optional<fs_watcher::action> apply_change_unsafe(
+        const std::filesystem::path&, fs_watcher::action);
 
 
-    void populate_item_unsafe     (const std::filesystem::path&, listing_mode);
-    void populate_directory_unsafe(const std::filesystem::path&, listing_mode);
-    void populate_lists_unsafe();
+    struct population {
+      std::unique_lock<std::mutex>& lock;
+      const std::stop_token&        stoken;
+      batch_callback&               on_batch;
+      size_t                        reported  {0};
+      size_t                        batch_size;
+    };
+
+    void populate_item_unsafe     (const std::filesystem::path&, listing_mode,
+                                   population&);
+    void populate_directory_unsafe(const std::filesystem::path&, listing_mode,
+                                   population&);
+    void populate_lists_unsafe    (population&);
+    // sniffs pending files and reports newly listed ones, unlocking in the meantime
+    void flush_unsafe(population&);
 
     [[nodiscard]] listing_mode determine_mode_unsafe(const std::filesystem::path&) const;
 };
@@ -0,0 +1,46 @@
+#ifndef PHODISPL_FILE_PREFETCHER_HPP_INCLUDED
+#define PHODISPL_FILE_PREFETCHER_HPP_INCLUDED
+
+#include "phodispl/image.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+// asks the kernel to read files into the page cache ahead of decoding them
+class file_prefetcher {
+  public:
+    file_prefetcher(const file_prefetcher&) = delete;
+    file_prefetcher(file_prefetcher&&)      = delete;
+    file_prefetcher& operator=(const file_prefetcher&) = delete;
+    file_prefetcher& operator=(file_prefetcher&&)      = delete;
+
+    ~file_prefetcher();
+
+    file_prefetcher();
+
+
+
+    // replaces everything still pending, most important image first
+    void prefetch(std::vector<std::shared_ptr<image>>);
+
+
+
+  private:
+    std::deque<std::shared_ptr<image>> pending_;
+    std::mutex                         pending_mutex_;
+    std::condition_variable_any        pending_wakeup_;
+
+    std::jthread                       prefetch_thread_;
+
+
+
+    void prefetch_loop(const std::stop_token&);
+};
+
+#endif // PHODISPL_FILE_PREFETCHER_HPP_INCLUDED
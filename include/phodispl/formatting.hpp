@@ -4,6 +4,7 @@
 #ifndef PHODISPL_FORMATTING_HPP_INCLUDED
 #define PHODISPL_FORMATTING_HPP_INCLUDED
 
+#include <chrono>
 #include <filesystem>
 #include <functional>
 #include <string>
@@ -13,6 +14,8 @@
 
 [[nodiscard]] std::u32string format_byte_size(size_t);
 [[nodiscard]] std::u32string to_u32string(size_t);
+// with one decimal place
+[[nodiscard]] std::u32string format_milliseconds(std::chrono::microseconds);
 
 
 
@@ -1,11 +1,14 @@
 #ifndef PHODISPL_FS_WATCHER_HPP_INCLUDED
 #define PHODISPL_FS_WATCHER_HPP_INCLUDED
 
+#include "phodispl/config-types.hpp"
+
 #include <filesystem>
 #include <functional>
 #include <span>
 #include <thread>
-#include <vector>
+#include <unordered_map>
+#include <utility>
 
 
 
@@ -22,6 +25,11 @@ class fs_watcher {
     using callback =
       std::move_only_function<void(const std::filesystem::path&, action) const>;
 
+    using event = std::pair<std::filesystem::path, action>;
+
+    // called when the kernel dropped events, every watched path may have changed since
+    using overflow_callback = std::move_only_function<void() const>;
+
 
 
     fs_watcher(const fs_watcher&) = delete;
@@ -30,7 +38,10 @@ class fs_watcher {
     fs_watcher& operator=(fs_watcher&&)      = delete;
 
     ~fs_watcher();
-    fs_watcher(callback&&);
+    // with directory granularity, files inside of watched directories are only observed
+    // through the events of their directory
+    explicit fs_watcher(callback&&, watch_granularity = watch_granularity::files,
+                        overflow_callback = {});
 
 
 
@@ -54,23 +65,30 @@ class fs_watcher {
     };
 
     struct watch_item {
-      int                   wd;
       std::filesystem::path path;
+      bool                  directory;
     };
 
-    using watch_iter = std::vector<watch_item>::iterator;
+    using watch_map  = std::unordered_map<int, watch_item>;
+    using watch_iter = watch_map::iterator;
+
 
 
+    callback                                       callback_;
+    watch_granularity                              granularity_;
+    overflow_callback                              overflow_callback_;
 
-    callback                callback_;
+    pipe_fd                                        watch_pipe_;
+    int                                            fd_          {-1};
 
-    pipe_fd                 watch_pipe_;
-    int                     fd_          {-1};
+    std::mutex                                     mutex_;
 
-    std::jthread            watch_thread_;
-    std::mutex              mutex_;
+    // indexed by watch descriptor and by path, events must not scan all watches
+    watch_map                                      file_watches_;
+    std::unordered_map<std::filesystem::path, int> watch_descriptors_;
 
-    std::vector<watch_item> file_watches_;
+    // started last, it uses all other members
+    std::jthread                                   watch_thread_;
 
 
 
@@ -85,6 +103,7 @@ class fs_watcher {
     void handle_event          (const inotify_event*);
     void handle_file_event     (watch_iter, uint32_t);
     void handle_directory_event(watch_iter, uint32_t, const std::filesystem::path&);
+    void handle_entry_event    (uint32_t, const std::filesystem::path&);
 
     watch_iter remove_watch(watch_iter);
 
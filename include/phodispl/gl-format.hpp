@@ -0,0 +1,45 @@
+#ifndef PHODISPL_GL_FORMAT_HPP_INCLUDED
+#define PHODISPL_GL_FORMAT_HPP_INCLUDED
+
+#include "phodispl/texture-pool.hpp"
+
+#include <cstddef>
+
+#include <gl/base.hpp>
+#include <gl/texture.hpp>
+
+#include <pixglot/pixel-format.hpp>
+
+
+
+struct gl_pixel_format {
+  GLenum internal;
+  GLenum format;
+  GLenum type;
+  size_t channels;
+  size_t channel_size;
+
+  [[nodiscard]] size_t pixel_size() const { return channels * channel_size; }
+};
+
+[[nodiscard]] gl_pixel_format gl_format_for(pixglot::pixel_format);
+
+
+
+// number of mipmap levels for a texture of this size ([image-loading] mipmaps)
+[[nodiscard]] size_t texture_levels(size_t, size_t);
+
+// generates the mipmaps of the bound texture and records their cost in the statistics
+void generate_mipmaps(const texture_key&);
+
+
+
+// takes a matching texture from the pool (if any) or allocates a new one, the returned
+// texture is bound
+[[nodiscard]] gl::texture acquire_texture(
+    texture_pool*,
+    const texture_key&,
+    pixglot::color_channels
+);
+
+#endif // PHODISPL_GL_FORMAT_HPP_INCLUDED
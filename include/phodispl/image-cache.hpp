@@ -2,21 +2,40 @@
 #define PHODISPL_IMAGE_CACHE_HPP_INCLUDED
 
 #include "phodispl/image.hpp"
+#include "phodispl/navigation-predictor.hpp"
 
 #include <filesystem>
 #include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
 #include <vector>
 
+#include <order-statistic-tree.hpp>
+
+
+
+// images that finished loading and the size of their decoded pixels
+struct cache_occupancy {
+  size_t images{0};
+  size_t bytes {0};
+};
+
 
 
 class image_cache {
   public:
+    using prefetch_function =
+      std::move_only_function<void(std::vector<std::shared_ptr<image>>) const>;
+
     image_cache(
         std::move_only_function<void(const std::shared_ptr<image>&, size_t) const> load,
-        std::move_only_function<void(const std::shared_ptr<image>&, bool)   const> unload
+        std::move_only_function<void(const std::shared_ptr<image>&, bool)   const> unload,
+        prefetch_function prefetch = {}
     ) :
-      load_function_  {std::move(load)},
-      unload_function_{std::move(unload)}
+      load_function_    {std::move(load)},
+      unload_function_  {std::move(unload)},
+      prefetch_function_{std::move(prefetch)}
     {}
 
 
@@ -24,6 +43,8 @@ class image_cache {
     void set(std::span<const std::filesystem::path>);
 
     void add       (const std::filesystem::path&);
+    // merges files which are not known yet, keeping the current image
+    void add       (std::span<const std::filesystem::path>);
     void remove    (const std::filesystem::path&);
     void invalidate(const std::filesystem::path&);
 
@@ -38,6 +59,13 @@ class image_cache {
 
     void ensure_loaded() const;
 
+    // when the predicted window falls back to the plain one, ensure_loaded() has to be
+    // called again afterwards
+    [[nodiscard]] std::optional<navigation_predictor::clock::time_point>
+      prediction_expiry() const { return predictor_.expiry(); }
+    // re-evaluates which neighbors fit into [cache] memory-budget, if one is set
+    void fit_budget() const;
+
 
     [[nodiscard]] std::shared_ptr<image> current() const;
 
@@ -46,6 +74,12 @@ class image_cache {
     [[nodiscard]] bool   empty() const { return images_.empty(); }
     [[nodiscard]] size_t size()  const { return images_.size(); }
 
+    // kept up to date by loaded() and unloading, does not visit the images
+    [[nodiscard]] cache_occupancy occupancy() const { return occupancy_; }
+
+    // accounts for an image which finished loading, if it is still cached
+    void loaded(const std::shared_ptr<image>&);
+
 
 
 
@@ -55,16 +89,48 @@ class image_cache {
       load_function_;
     std::move_only_function<void(const std::shared_ptr<image>&, bool) const>
       unload_function_;
+    prefetch_function                   prefetch_function_;
 
-    std::vector<std::shared_ptr<image>> images_;
+    order_statistic_tree<std::shared_ptr<image>>
+                                        images_;
     size_t                              index_{0};
 
+    navigation_predictor                predictor_;
+    mutable neighbor_window             last_budget_window_;
+    mutable neighbor_window             last_load_window_;
+    // neighbors which may hold loaded images, relative to the image current at the last
+    // cleanup
+    mutable neighbor_window             loaded_extent_;
+    // the load window of the operation in progress, computed at most once per operation
+    mutable std::optional<neighbor_window> load_window_;
+
+    // decoded size of every loaded image as accounted in occupancy_
+    mutable std::unordered_map<const image*, size_t>
+                                        accounted_;
+    mutable cache_occupancy             occupancy_;
+
+
+
+    [[nodiscard]] neighbor_window load_window() const;
+    [[nodiscard]] neighbor_window keep_window() const;
+    [[nodiscard]] neighbor_window budget_window() const;
+    [[nodiscard]] neighbor_window read_window() const;
+
+    [[nodiscard]] size_t index_at_rank(size_t) const;
+
+    // starts a new operation, the windows have to be determined again
+    void reset_windows() const { load_window_.reset(); }
+
 
 
     void load_maybe(size_t) const;
+    void load_neighbors() const;
 
     void load_unsafe(size_t, size_t) const;
     void unload_unsafe(size_t) const;
+    void forget(const image*) const;
+
+    void prefetch_outside(neighbor_window) const;
 
 
 
@@ -7,6 +7,7 @@
 #include "phodispl/animation.hpp"
 #include "phodispl/config-types.hpp"
 #include "phodispl/image.hpp"
+#include "phodispl/image-frame.hpp"
 #include "phodispl/infobar.hpp"
 #include "phodispl/message-box.hpp"
 #include "phodispl/progress-circle.hpp"
@@ -51,7 +52,7 @@ class image_display : public win::widget {
     std::shared_ptr<image>      current_;
     std::shared_ptr<image>      previous_;
 
-    std::optional<pixglot::frame_view>
+    std::shared_ptr<const image_frame>
                                 current_frame_;
 
     animation_time              crossfade_;
@@ -85,9 +86,16 @@ class image_display : public win::widget {
 
 
     [[nodiscard]] float     current_scale(scale_mode)                               const;
-    [[nodiscard]] float     scale_any    (const pixglot::frame_view&, scale_mode)   const;
-    [[nodiscard]] float     scale_dynamic(const pixglot::frame_view&, dynamic_scale)const;
-    [[nodiscard]] win::mat4 matrix_for   (const pixglot::frame_view&)               const;
+    [[nodiscard]] float     scale_any    (const image_frame&, scale_mode)           const;
+    [[nodiscard]] float     scale_dynamic(const image_frame&, dynamic_scale)        const;
+    [[nodiscard]] float     animated_scale(const image_frame&)                      const;
+    [[nodiscard]] win::mat4 matrix_for   (const image_frame&)                       const;
+    [[nodiscard]] bool      minified_mipmaps(const image_frame&)                    const;
+
+
+
+    void render_single(const image_frame&, float);
+    void render_tiled (const image_frame&, float);
 
 
 
@@ -0,0 +1,108 @@
+#ifndef PHODISPL_IMAGE_FRAME_HPP_INCLUDED
+#define PHODISPL_IMAGE_FRAME_HPP_INCLUDED
+
+#include "phodispl/pixel-source.hpp"
+#include "phodispl/texture-pool.hpp"
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <gl/texture.hpp>
+
+#include <pixglot/frame.hpp>
+#include <pixglot/frame-source-info.hpp>
+#include <pixglot/square-isometry.hpp>
+
+
+
+// whether a frame of this size needs to be split into tiles
+[[nodiscard]] bool requires_tiling(size_t, size_t);
+
+
+
+
+
+class image_frame {
+  public:
+    struct region {
+      size_t x;
+      size_t y;
+      size_t width;
+      size_t height;
+    };
+
+    struct tile {
+      // the part of the frame drawn from this tile
+      region      covered;
+      // the part of the frame stored in the texture, which includes a border of one
+      // texel toward every neighboring tile, so that filtering matches across edges
+      region      stored;
+      gl::texture texture;
+    };
+
+
+
+    image_frame(const image_frame&) = delete;
+    image_frame(image_frame&&)      = delete;
+    image_frame& operator=(const image_frame&) = delete;
+    image_frame& operator=(image_frame&&)      = delete;
+
+    ~image_frame();
+
+    // texture is owned and (partially) uploaded by pixglot
+    explicit image_frame(const pixglot::frame_view&);
+
+    // texture has been uploaded by phodispl and is returned to the pool (if it still
+    // exists) when the frame is dropped
+    image_frame(const source_frame&, gl::texture, const texture_key&,
+        std::weak_ptr<texture_pool>);
+
+    // frame is split into tiles, which are uploaded on demand from the retained pixels
+    image_frame(source_frame, std::weak_ptr<texture_pool>);
+
+
+
+    [[nodiscard]] size_t width()  const { return width_;  }
+    [[nodiscard]] size_t height() const { return height_; }
+
+    [[nodiscard]] pixglot::square_isometry orientation() const { return orientation_; }
+
+    [[nodiscard]] const pixglot::frame_source_info& source_info() const {
+      return source_info_;
+    }
+
+
+
+    void bind() const;
+
+    [[nodiscard]] bool mipmapped() const { return mipmapped_; }
+
+
+
+    [[nodiscard]] bool                  tiled() const { return !tiles_.empty(); }
+    [[nodiscard]] std::span<const tile> tiles() const { return tiles_;          }
+
+    // uploads the tile if it has no texture yet (render thread only)
+    void upload_tile(size_t) const;
+
+
+
+  private:
+    size_t                             width_;
+    size_t                             height_;
+    pixglot::square_isometry           orientation_;
+    pixglot::frame_source_info         source_info_;
+
+    std::optional<pixglot::frame_view> view_;
+    gl::texture                        texture_;
+    texture_key                        texture_key_;
+    std::weak_ptr<texture_pool>        pool_;
+    bool                               mipmapped_{false};
+
+    pixel_source                       tile_source_;
+    mutable std::vector<tile>          tiles_;
+};
+
+#endif // PHODISPL_IMAGE_FRAME_HPP_INCLUDED
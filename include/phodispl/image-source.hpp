@@ -2,16 +2,26 @@
 #define PHODISPL_IMAGE_SOURCE_HPP_INCLUDED
 
 #include "phodispl/file-listing.hpp"
+#include "phodispl/file-prefetcher.hpp"
 #include "phodispl/image-cache.hpp"
 #include "phodispl/image.hpp"
+#include "phodispl/texture-pool.hpp"
+#include "phodispl/texture-uploader.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
 #include <filesystem>
 #include <thread>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include <indexed-heap.hpp>
+
 #include <win/application.hpp>
+#include <win/context.hpp>
 
 
 
@@ -27,11 +37,25 @@ enum class image_change {
 
 
 
+// snapshot of the loading pipeline
+struct load_status {
+  size_t          scheduled    {0};
+  size_t          loading      {0};
+  size_t          workers      {0};
+  cache_occupancy cache;
+  size_t          pooled_bytes {0};
+};
+
+
+
 class image_source {
   public:
     using callback =
       std::move_only_function<void(std::shared_ptr<image>, image_change)>;
 
+    // creates contexts sharing objects with the one used for rendering
+    using context_factory = std::move_only_function<win::context()>;
+
 
 
     image_source(const image_source&) = delete;
@@ -43,6 +67,9 @@ class image_source {
     explicit image_source(callback&&,
         std::vector<std::filesystem::path>, const win::application&);
 
+    explicit image_source(callback&&,
+        std::vector<std::filesystem::path>, context_factory);
+
     ~image_source();
 
 
@@ -59,45 +86,85 @@ class image_source {
 
     [[nodiscard]] std::shared_ptr<image> current() const;
 
+    [[nodiscard]] size_t load_threads() const { return worker_count_; }
+
+    [[nodiscard]] load_status status() const;
+
+    // pools the textures of dropped frames, requires the rendering context
+    void collect_textures() { texture_pool_->collect(); }
+
+    // whether files are still being listed in the background
+    [[nodiscard]] bool listing() const { return listing_; }
+    void wait_for_listing();
+
 
 
 
 
   private:
     callback                              callback_;
+    file_prefetcher                       prefetcher_;
     image_cache                           cache_;
     mutable std::mutex                    cache_mutex_;
 
     file_listing                          file_listing_;
 
     using prio_shared_image = std::pair<size_t, std::shared_ptr<image>>;
-    std::vector<prio_shared_image>        scheduled_images_;
-    std::optional<std::shared_ptr<image>> loading_image_;
-    bool                                  aborted_loading_{false};
-    std::vector<const image*>             unscheduled_images_;
-    std::mutex                            scheduled_images_lock_;
-
-    std::jthread                          worker_thread_;
+    // stored priorities are relative to schedule_offset_ and may become negative
+    indexed_heap<std::shared_ptr<image>, std::ptrdiff_t>
+                                          scheduled_images_;
+    std::ptrdiff_t                        schedule_offset_{0};
+    std::vector<prio_shared_image>        loading_images_;
+    std::unordered_set<const image*>      unscheduled_images_;
+    mutable std::mutex                    scheduled_images_lock_;
+
+    using clock = std::chrono::steady_clock;
+    clock::time_point                     last_navigation_;
+    clock::time_point                     hold_until_;
+    // the last expired navigation prediction the load window has been updated for
+    clock::time_point                     refreshed_expiry_;
+
+    std::shared_ptr<texture_pool>         texture_pool_;
+    texture_uploader                      uploader_;
+
+    size_t                                worker_count_;
     std::mutex                            worker_mutex_;
-    std::condition_variable               worker_wakeup_;
+    std::condition_variable_any           worker_wakeup_;
+    std::vector<std::jthread>             worker_threads_;
 
     win::context                          filesystem_context_;
     std::thread::id                       main_thread_id_;
 
+    std::atomic<bool>                     listing_{false};
+    std::jthread                          lister_;
+
 
 
     void unload_image    (const std::shared_ptr<image>&, bool);
     void schedule_image  (const std::shared_ptr<image>&, size_t);
     void unschedule_image(const std::shared_ptr<image>&);
-    [[nodiscard]] std::shared_ptr<image> next_scheduled_image();
+    [[nodiscard]] std::optional<prio_shared_image> next_scheduled_image();
+    // whether next_scheduled_image() would return an image
+    [[nodiscard]] bool work_available() const;
+    void finish_loading(const std::shared_ptr<image>&);
+    void preempt_loading_unguarded();
+
+    void note_navigation();
+    [[nodiscard]] std::optional<clock::time_point> held_until();
+    [[nodiscard]] std::optional<clock::time_point> pending_prediction_expiry() const;
+    void refresh_expired_prediction();
 
-    void work_loop(const std::stop_token&);
+    void work_loop(const std::stop_token&, size_t);
 
-    void on_file_changed(const std::filesystem::path&, fs_watcher::action);
+    void on_files_changed(std::vector<fs_watcher::event>);
+    void on_file_changed_unguarded(const std::filesystem::path&, fs_watcher::action);
 
 
 
-    void populate_cache(std::unique_lock<std::mutex>);
+    void start_listing();
+    void stop_listing();
+    void list_files(const std::stop_token&);
+    void add_listed_files(std::vector<std::filesystem::path>);
 
 
 
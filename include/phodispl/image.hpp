@@ -2,14 +2,21 @@
 #define PHODISPL_IMAGE_HPP_INCLUDED
 
 #include "phodispl/damageable.hpp"
+#include "phodispl/image-frame.hpp"
+#include "phodispl/pixel-source.hpp"
 #include "phodispl/sequence-clock.hpp"
+#include "phodispl/texture-uploader.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
+#include <gl/base.hpp>
+
 #include <pixglot/exception.hpp>
 #include <pixglot/frame.hpp>
 #include <pixglot/image.hpp>
@@ -17,6 +24,16 @@
 
 
 
+// time spent on the stages of the last load
+struct load_timing {
+  // reading and decoding, or mapping the disk cache entry
+  std::chrono::steady_clock::duration decode{0};
+  // waiting for and running the upload (zero when decoded directly into textures)
+  std::chrono::steady_clock::duration upload{0};
+};
+
+
+
 class image :
   public damageable,
   public std::enable_shared_from_this<image>
@@ -32,10 +49,15 @@ class image :
 
 
     [[nodiscard]] static std::shared_ptr<image> create(const std::filesystem::path&);
+    // with the sort key of the path, if already known
+    [[nodiscard]] static std::shared_ptr<image> create(const std::filesystem::path&,
+                                                       std::string);
 
 
 
-    void load();
+    // decodes directly into textures (to show partial progress) if requested and
+    // possible, otherwise the uploader creates the textures in order of the load priority
+    void load(texture_uploader&, size_t, bool = false);
     void update();
     void clear();
 
@@ -48,13 +70,17 @@ class image :
 
     [[nodiscard]] const std::filesystem::path& path() const { return path_; }
 
+    // orders images by [file-listing] sort-mode when compared byte-wise
+    [[nodiscard]] const std::string& sort_key() const { return sort_key_; }
+
 
 
     [[nodiscard]] operator bool()  const { return loading_started_;   }
 
     [[nodiscard]] float progress() const { return ptoken_.progress(); }
-    [[nodiscard]] bool  loading()  const { return loading_started_ && !loading_finished_;}
-    [[nodiscard]] bool  finished() const { return loading_finished_; }
+    [[nodiscard]] bool  loading()  const { return loading_started_ && !finished(); }
+    // polls the upload fence, requires a current gl context
+    [[nodiscard]] bool  finished() const;
 
     void abort_loading();
 
@@ -64,7 +90,7 @@ class image :
 
 
 
-    [[nodiscard]] std::optional<pixglot::frame_view> current_frame() const;
+    [[nodiscard]] std::shared_ptr<const image_frame> current_frame() const;
 
     [[nodiscard]] size_t frame_count()   const { return frames_.size(); }
     [[nodiscard]] size_t frame_index()   const { return current_frame_; }
@@ -85,20 +111,35 @@ class image :
 
     [[nodiscard]] size_t file_size() const { return file_size_; }
 
+    [[nodiscard]] load_timing timing() const;
+
+    // size of the decoded pixels (in textures or waiting for upload), 0 until decoded
+    [[nodiscard]] size_t texture_bytes() const { return texture_bytes_; }
+
+    // whether the file has been read ahead since the image was last cleared
+    [[nodiscard]] bool prefetched() const { return prefetched_; }
+    void set_prefetched() { prefetched_ = true; }
+
 
 
 
 
   private:
     std::filesystem::path                    path_;
+    std::string                              sort_key_;
 
     std::atomic<bool>                        loading_started_ {false};
     std::atomic<bool>                        loading_finished_{false};
     pixglot::progress_token                  ptoken_;
     std::unique_ptr<pixglot::base_exception> error_;
 
-    std::vector<pixglot::frame_view>         frames_;
+    std::vector<std::shared_ptr<const image_frame>>
+                                             frames_;
     mutable std::mutex                       frames_mutex_;
+    size_t                                   generation_{0};
+    mutable GLsync                           fence_{nullptr};
+    mutable bool                             fence_waited_{false};
+    std::chrono::steady_clock::time_point    fence_created_;
     size_t                                   current_frame_{0};
     sequence_clock                           frame_sequence_;
 
@@ -106,15 +147,34 @@ class image :
     std::chrono::steady_clock::time_point    frame_partial_last_update_;
 
     std::optional<pixglot::image>            image_;
+    std::vector<std::string>                 warnings_;
     std::optional<pixglot::codec>            codec_;
     size_t                                   file_size_{0};
+    std::atomic<size_t>                      texture_bytes_{0};
+    std::atomic<bool>                        prefetched_{false};
+    bool                                     requires_tiling_{false};
+
+    std::chrono::steady_clock::time_point    load_started_;
+    std::chrono::steady_clock::time_point    upload_started_;
+    load_timing                              timing_;
 
 
 
 
     void seek_frame(ssize_t);
 
-    explicit image(std::filesystem::path path) : path_{std::move(path)} {}
+    void upload_frames(texture_uploader&, std::vector<source_frame>, size_t);
+    void update_frame_sequence(std::vector<std::chrono::microseconds>);
+    void finish_upload(size_t, texture_uploader::result);
+
+    void set_fence_unguarded(GLsync);
+    bool poll_fence_unguarded() const;
+    void delete_fence_unguarded() const;
+
+    image(std::filesystem::path path, std::string sort_key) :
+      path_    {std::move(path)},
+      sort_key_{std::move(sort_key)}
+    {}
 };
 
 #endif // PHODISPL_IMAGE_HPP_INCLUDED
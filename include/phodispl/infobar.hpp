@@ -11,11 +11,8 @@
 
 #include <pixglot/codecs.hpp>
 
-namespace pixglot {
-  class frame_view;
-}
-
 class image;
+class image_frame;
 
 
 
@@ -23,7 +20,7 @@ class infobar : public fade_widget {
   public:
     infobar();
 
-    void set_frame(const pixglot::frame_view&);
+    void set_frame(const image_frame&);
     void set_image(const image&);
 
     void clear_frame();
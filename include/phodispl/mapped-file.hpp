@@ -0,0 +1,37 @@
+#ifndef PHODISPL_MAPPED_FILE_HPP_INCLUDED
+#define PHODISPL_MAPPED_FILE_HPP_INCLUDED
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+
+
+// read-only memory mapping of a whole file
+class mapped_file {
+  public:
+    mapped_file(const mapped_file&) = delete;
+    mapped_file(mapped_file&&)      = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file& operator=(mapped_file&&)      = delete;
+
+    ~mapped_file();
+
+    explicit mapped_file(const std::filesystem::path&);
+
+
+
+    [[nodiscard]] std::span<const std::byte> data() const { return {data_, size_}; }
+    [[nodiscard]] size_t                     size() const { return size_;          }
+
+    // forwards to madvise for the whole mapping
+    void advise(int) const;
+
+
+
+  private:
+    std::byte* data_{nullptr};
+    size_t     size_{0};
+};
+
+#endif // PHODISPL_MAPPED_FILE_HPP_INCLUDED
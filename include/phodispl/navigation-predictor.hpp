@@ -0,0 +1,53 @@
+#ifndef PHODISPL_NAVIGATION_PREDICTOR_HPP_INCLUDED
+#define PHODISPL_NAVIGATION_PREDICTOR_HPP_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <sys/types.h>
+
+
+
+struct neighbor_window {
+  size_t forward {0};
+  size_t backward{0};
+
+  [[nodiscard]] bool operator==(const neighbor_window&) const = default;
+};
+
+
+
+
+
+// estimates direction and rate of navigation from the sequence of seeks
+class navigation_predictor {
+  public:
+    using clock = std::chrono::steady_clock;
+
+
+
+    void record(ssize_t, clock::time_point = clock::now());
+
+    // images per second, positive when moving forward, 0 when idle
+    [[nodiscard]] float velocity(clock::time_point = clock::now()) const;
+
+    // skews the window toward the direction of travel and, if requested,
+    // stretches it with the current rate
+    [[nodiscard]] neighbor_window predict(
+        neighbor_window,
+        bool              stretch = true,
+        clock::time_point         = clock::now()
+    ) const;
+
+    // when predict() falls back to the unchanged window, unless there are further seeks;
+    // empty if it does not alter the window
+    [[nodiscard]] std::optional<clock::time_point> expiry() const;
+
+
+
+  private:
+    float             velocity_{0.f};
+    clock::time_point last_seek_;
+};
+
+#endif // PHODISPL_NAVIGATION_PREDICTOR_HPP_INCLUDED
@@ -5,6 +5,7 @@
 #define PHODISPL_PATH_COMPARE_HPP_INCLUDED
 
 #include <filesystem>
+#include <string>
 #include <string_view>
 
 
@@ -19,6 +20,10 @@ enum class path_compare_method {
 
 [[nodiscard]] bool semantic_compare(std::string_view, std::string_view);
 
+// binary keys whose byte-wise order (as std::string) is the order of the comparison
+[[nodiscard]] std::string semantic_sort_key     (std::string_view);
+[[nodiscard]] std::string lexicographic_sort_key(const std::filesystem::path&);
+
 
 
 class path_compare {
@@ -41,6 +46,15 @@ class path_compare {
 
 
 
+    [[nodiscard]] std::string key(const std::filesystem::path& path) const {
+      if (method_ == path_compare_method::semantic) {
+        return semantic_sort_key(path.native());
+      }
+      return lexicographic_sort_key(path);
+    }
+
+
+
   private:
     path_compare_method method_;
 };
@@ -0,0 +1,64 @@
+#ifndef PHODISPL_PERF_HUD_HPP_INCLUDED
+#define PHODISPL_PERF_HUD_HPP_INCLUDED
+
+#include "phodispl/fade-widget.hpp"
+#include "phodispl/image-source.hpp"
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+
+#include <gl/mesh.hpp>
+#include <gl/program.hpp>
+
+
+
+// overlay with live numbers of the rendering and loading pipeline;
+// samples are only taken while it is visible
+class perf_hud : public fade_widget {
+  public:
+    using duration = std::chrono::steady_clock::duration;
+
+    struct sample {
+      duration                frame_time    {0};
+      duration                frame_interval{0};
+      std::optional<duration> decode;
+      load_status             status;
+    };
+
+    using sample_function = std::move_only_function<sample()>;
+
+
+
+    explicit perf_hud(sample_function);
+
+    void toggle();
+
+
+
+  private:
+    static constexpr size_t line_count{6};
+
+    sample_function                        sample_;
+    std::chrono::steady_clock::time_point  next_sample_;
+
+    gl::mesh                               quad_;
+    gl::program                            shader_;
+    GLint                                  shader_trafo_;
+    GLint                                  shader_color_;
+
+    std::array<std::u32string, line_count> values_;
+
+
+
+    void on_update() override;
+    void on_render() override;
+
+    void on_layout(vec2<std::optional<float>>& /*size*/) override;
+
+    void update_values(const sample&);
+};
+
+#endif // PHODISPL_PERF_HUD_HPP_INCLUDED
@@ -0,0 +1,41 @@
+#ifndef PHODISPL_PIXEL_SOURCE_HPP_INCLUDED
+#define PHODISPL_PIXEL_SOURCE_HPP_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include <pixglot/frame-source-info.hpp>
+#include <pixglot/pixel-format.hpp>
+#include <pixglot/square-isometry.hpp>
+
+
+
+// decoded pixels of one frame (from a pixglot buffer or mapped from the disk cache),
+// valid as long as owner is alive
+struct pixel_source {
+  std::span<const std::byte>  data;
+  size_t                      width {0};
+  size_t                      height{0};
+  size_t                      stride{0};
+  pixglot::pixel_format       format{};
+  std::shared_ptr<const void> owner;
+};
+
+
+
+struct frame_properties {
+  pixglot::square_isometry   orientation{pixglot::square_isometry::identity};
+  pixglot::frame_source_info source_info;
+  std::chrono::microseconds  duration   {0};
+};
+
+
+
+struct source_frame {
+  pixel_source     pixels;
+  frame_properties properties;
+};
+
+#endif // PHODISPL_PIXEL_SOURCE_HPP_INCLUDED
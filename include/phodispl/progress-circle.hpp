@@ -14,11 +14,14 @@ class progress_circle : public fade_widget {
 
 
     void value(float);
+    // for work of unknown size, the arc grows and shrinks until a value is set
+    void indeterminate();
 
 
 
   private:
-    float            value_     {0.f};
+    float            value_        {0.f};
+    bool             indeterminate_{false};
 
     gl::mesh         quad_;
     gl::program      shader_;
@@ -0,0 +1,48 @@
+#ifndef PHODISPL_STATISTICS_HPP_INCLUDED
+#define PHODISPL_STATISTICS_HPP_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+
+struct statistics {
+  std::atomic<uint64_t> fence_waits  {0};
+  std::atomic<uint64_t> fence_wait_us{0};
+
+  std::atomic<uint64_t> avoided_decodes{0};
+
+  std::atomic<uint64_t> texture_pool_hits  {0};
+  std::atomic<uint64_t> texture_pool_misses{0};
+
+  std::atomic<uint64_t> dropped_uploads{0};
+
+  std::atomic<uint64_t> mipmap_chains         {0};
+  std::atomic<uint64_t> mipmap_generated_bytes{0};
+
+  std::atomic<uint64_t> disk_cache_hits  {0};
+  std::atomic<uint64_t> disk_cache_misses{0};
+  std::atomic<uint64_t> disk_cache_stores{0};
+
+  std::atomic<uint64_t> prefetched_files{0};
+  std::atomic<uint64_t> prefetched_bytes{0};
+
+  std::atomic<uint64_t> suppressed_fs_events{0};
+
+
+
+  void add_fence_wait(std::chrono::steady_clock::duration duration) {
+    fence_waits++;
+    fence_wait_us += std::chrono::duration_cast<std::chrono::microseconds>(duration)
+                       .count();
+  }
+};
+
+
+
+[[nodiscard]] statistics& global_statistics();
+
+void log_statistics();
+
+#endif // PHODISPL_STATISTICS_HPP_INCLUDED
@@ -0,0 +1,77 @@
+#ifndef PHODISPL_TEXTURE_POOL_HPP_INCLUDED
+#define PHODISPL_TEXTURE_POOL_HPP_INCLUDED
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <gl/base.hpp>
+#include <gl/texture.hpp>
+
+
+
+struct texture_key {
+  size_t width          {0};
+  size_t height         {0};
+  GLenum internal_format{0};
+  size_t levels         {1};
+
+  [[nodiscard]] bool operator==(const texture_key&) const = default;
+};
+
+[[nodiscard]] size_t byte_size(const texture_key&);
+
+
+
+
+
+// keeps textures of dropped frames around to be reused for frames of equal size and
+// format; all functions except release() require a current gl context of the shared group
+class texture_pool {
+  public:
+    texture_pool(const texture_pool&) = delete;
+    texture_pool(texture_pool&&)      = delete;
+    texture_pool& operator=(const texture_pool&) = delete;
+    texture_pool& operator=(texture_pool&&)      = delete;
+
+    ~texture_pool();
+
+    explicit texture_pool(size_t);
+
+
+
+    // returns an empty texture if no matching one is available
+    [[nodiscard]] gl::texture acquire(const texture_key&);
+    // may be called from any thread, the texture becomes available after the next collect()
+    void release(const texture_key&, gl::texture);
+    // pools the released textures; must be called from the rendering thread, which
+    // issued the last commands reading from them
+    void collect();
+
+    void clear();
+
+    // size of the textures currently kept for reuse
+    [[nodiscard]] size_t bytes() const;
+
+
+
+  private:
+    struct entry {
+      texture_key key;
+      gl::texture texture;
+      GLsync      fence{nullptr};
+    };
+
+    mutable std::mutex mutex_;
+    std::deque<entry>  entries_;
+    std::vector<entry> released_;
+    size_t             bytes_{0};
+    size_t             capacity_;
+
+
+
+    void drop_oldest_unguarded();
+};
+
+#endif // PHODISPL_TEXTURE_POOL_HPP_INCLUDED
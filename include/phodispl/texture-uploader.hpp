@@ -0,0 +1,80 @@
+#ifndef PHODISPL_TEXTURE_UPLOADER_HPP_INCLUDED
+#define PHODISPL_TEXTURE_UPLOADER_HPP_INCLUDED
+
+#include "phodispl/image-frame.hpp"
+#include "phodispl/pixel-source.hpp"
+#include "phodispl/texture-pool.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gl/base.hpp>
+
+#include <win/context.hpp>
+
+
+
+class texture_uploader {
+  public:
+    struct result {
+      std::vector<std::shared_ptr<const image_frame>> frames;
+      std::optional<std::string>                      error;
+      GLsync                                          fence{nullptr};
+    };
+
+    using callback = std::move_only_function<void(result)>;
+    // false once the textures are not needed anymore (e.g. the image has been unloaded)
+    using validity = std::move_only_function<bool()>;
+
+
+
+    texture_uploader(const texture_uploader&) = delete;
+    texture_uploader(texture_uploader&&)      = delete;
+    texture_uploader& operator=(const texture_uploader&) = delete;
+    texture_uploader& operator=(texture_uploader&&)      = delete;
+
+    ~texture_uploader();
+
+    texture_uploader(win::context, std::shared_ptr<texture_pool>);
+
+
+
+    // uploads all frames of a decoded image and reports the resulting textures on the
+    // upload thread; the most important job (lowest priority value, like load
+    // priorities) is uploaded first, jobs which became invalid are dropped unreported
+    void upload(std::vector<source_frame>, size_t, validity&&, callback&&);
+
+
+
+  private:
+    struct job {
+      std::vector<source_frame>       source;
+      size_t                          priority{0};
+      // submission order among jobs of equal priority
+      size_t                          sequence{0};
+      validity                        valid;
+      callback                        done;
+    };
+
+    // binary heap with the next job in front
+    std::vector<job>                  jobs_;
+    size_t                            job_sequence_{0};
+    std::mutex                        jobs_mutex_;
+    std::condition_variable_any       jobs_wakeup_;
+
+    std::shared_ptr<texture_pool>     pool_;
+
+    std::jthread                      upload_thread_;
+
+
+
+    void upload_loop(const std::stop_token&);
+};
+
+#endif // PHODISPL_TEXTURE_UPLOADER_HPP_INCLUDED
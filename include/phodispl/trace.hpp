@@ -0,0 +1,58 @@
+#ifndef PHODISPL_TRACE_HPP_INCLUDED
+#define PHODISPL_TRACE_HPP_INCLUDED
+
+#include <chrono>
+#include <filesystem>
+#include <string_view>
+
+
+
+// events are only recorded after tracing has been enabled
+void enable_tracing();
+[[nodiscard]] bool tracing_enabled();
+
+// names the calling thread in the trace
+void trace_thread_name(std::string_view);
+
+// writes the recorded events in the chrome trace event format (for perfetto or
+// chrome://tracing), once the traced threads have stopped
+void write_trace(const std::filesystem::path&);
+
+
+
+// records the time between construction and destruction as one event;
+// name must be a string literal, detail is copied (and truncated)
+class trace_zone {
+  public:
+    trace_zone(const trace_zone&) = delete;
+    trace_zone(trace_zone&&)      = delete;
+    trace_zone& operator=(const trace_zone&) = delete;
+    trace_zone& operator=(trace_zone&&)      = delete;
+
+    explicit trace_zone(const char* name, std::string_view detail = {}) :
+      name_{tracing_enabled() ? name : nullptr},
+      detail_{detail}
+    {
+      if (name_ != nullptr) {
+        begin_ = std::chrono::steady_clock::now();
+      }
+    }
+
+    ~trace_zone() {
+      if (name_ != nullptr) {
+        record(name_, detail_, begin_, std::chrono::steady_clock::now());
+      }
+    }
+
+
+
+  private:
+    const char*                           name_;
+    std::string_view                      detail_;
+    std::chrono::steady_clock::time_point begin_;
+
+    static void record(const char*, std::string_view,
+        std::chrono::steady_clock::time_point, std::chrono::steady_clock::time_point);
+};
+
+#endif // PHODISPL_TRACE_HPP_INCLUDED
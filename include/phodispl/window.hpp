@@ -5,6 +5,8 @@
 #include "phodispl/image-display.hpp"
 #include "phodispl/image-source.hpp"
 #include "phodispl/nav-button.hpp"
+#include "phodispl/perf-hud.hpp"
+#include "phodispl/progress-circle.hpp"
 
 #include <chrono>
 #include <filesystem>
@@ -34,6 +36,9 @@ class window : public win::application {
     nav_button                       nav_left_;
     nav_button                       nav_right_;
 
+    perf_hud                         perf_hud_;
+    progress_circle                  listing_progress_;
+
     std::chrono::steady_clock::time_point
                                      last_left_click_;
 
@@ -61,6 +66,8 @@ class window : public win::application {
 
     void update_title();
 
+    [[nodiscard]] perf_hud::sample perf_sample() const;
+
 
 
     void input_mode_scale(continuous_scale::direction, bool);
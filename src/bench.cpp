@@ -0,0 +1,415 @@
+#include "phodispl/config.hpp"
+#include "phodispl/image-source.hpp"
+#include "phodispl/statistics.hpp"
+#include "phodispl/trace.hpp"
+
+#include "build-config.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+
+#include <logcerr/log.hpp>
+
+#include <pixglot/codecs.hpp>
+
+#include <win/context-wayland.hpp>
+#include <win/context.hpp>
+#include <win/headless-egl.hpp>
+
+
+
+namespace {
+  using clock = std::chrono::steady_clock;
+
+  constexpr auto image_timeout = std::chrono::seconds{60};
+
+
+
+  void print_help() {
+    std::cout <<
+      "Usage: phodispl-bench [options] <input1>..\n"
+      "\n"
+      "Loads every image of the inputs one after another, like navigating through\n"
+      "them in phodispl, without opening a window.\n"
+      "\n"
+      "Options:\n"
+      " -h, --help           show this help and exit\n"
+      " -V, --verbose        enable verbose logging (use twice for debug output)\n"
+      " -c, --config=PATH    load configuration from PATH\n"
+      " -t, --threads=NUM    use NUM load threads instead of [cache] load-threads\n"
+      " -j, --json=PATH      write the results as json to PATH (- for stdout)\n"
+      "     --trace=PATH     record loading to PATH (chrome trace format)\n"
+      "\n";
+  }
+
+
+
+  [[nodiscard]] logcerr::severity verbosity_level(int verbosity) {
+    switch (verbosity) {
+      case 0:  return logcerr::severity::log;
+      case 1:  return logcerr::severity::verbose;
+      default: return logcerr::severity::debug;
+    }
+  }
+
+
+
+
+
+  struct sample {
+    std::string     codec;
+    clock::duration decode;
+    clock::duration upload;
+    clock::duration first_frame;
+    bool            failed;
+  };
+
+
+
+  struct codec_summary {
+    size_t          count {0};
+    size_t          failed{0};
+    clock::duration decode{0};
+    clock::duration upload{0};
+  };
+
+
+
+  struct summary {
+    size_t                               images{0};
+    size_t                               threads{0};
+    clock::duration                      total{0};
+    std::array<clock::duration, 3>       first_frame{};
+    std::map<std::string, codec_summary> codecs;
+
+    [[nodiscard]] double images_per_second() const {
+      return static_cast<double>(images) / std::chrono::duration<double>(total).count();
+    }
+  };
+
+
+
+  [[nodiscard]] double ms(clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  }
+
+
+
+  [[nodiscard]] clock::duration percentile(
+      std::vector<clock::duration>& values,
+      size_t                        p
+  ) {
+    if (values.empty()) {
+      return {};
+    }
+
+    auto index = std::min(values.size() - 1, values.size() * p / 100);
+    std::ranges::nth_element(values, values.begin() + index);
+    return values[index];
+  }
+
+
+
+  [[nodiscard]] summary summarize(
+      std::span<const sample> samples,
+      clock::duration         total,
+      size_t                  threads
+  ) {
+    summary sum;
+    sum.images  = samples.size();
+    sum.threads = threads;
+    sum.total   = total;
+
+    std::vector<clock::duration> first_frame;
+    first_frame.reserve(samples.size());
+
+    for (const auto& s: samples) {
+      first_frame.emplace_back(s.first_frame);
+
+      auto& codec = sum.codecs[s.codec];
+      codec.count++;
+      codec.failed += s.failed ? 1 : 0;
+      codec.decode += s.decode;
+      codec.upload += s.upload;
+    }
+
+    sum.first_frame = {
+      percentile(first_frame, 50),
+      percentile(first_frame, 95),
+      percentile(first_frame, 99)
+    };
+
+    return sum;
+  }
+
+
+
+
+
+  void print_text(const summary& sum) {
+    std::cout << std::fixed << std::setprecision(1)
+      << sum.images << " image(s) with " << sum.threads << " load thread(s) in "
+      << ms(sum.total) << " ms, " << sum.images_per_second() << " images/s\n"
+      << "time to first frame: p50 " << ms(sum.first_frame[0])
+      << " ms, p95 " << ms(sum.first_frame[1])
+      << " ms, p99 " << ms(sum.first_frame[2]) << " ms\n\n";
+
+    for (const auto& [name, codec]: sum.codecs) {
+      auto count = static_cast<double>(codec.count);
+      std::cout << std::setw(8) << name << ": " << codec.count << " image(s)";
+      if (codec.failed > 0) {
+        std::cout << " (" << codec.failed << " failed)";
+      }
+      std::cout << ", decode " << ms(codec.decode) / count
+        << " ms, upload " << ms(codec.upload) / count << " ms on average\n";
+    }
+  }
+
+
+
+  void print_json(std::ostream& out, const summary& sum) {
+    out << std::fixed << std::setprecision(3)
+      << "{\n"
+      << "  \"version\": \"" VERSION_STR "\",\n"
+      << "  \"threads\": " << sum.threads << ",\n"
+      << "  \"images\": " << sum.images << ",\n"
+      << "  \"total_ms\": " << ms(sum.total) << ",\n"
+      << "  \"images_per_second\": " << sum.images_per_second() << ",\n"
+      << "  \"time_to_first_frame_ms\": {"
+      << "\"p50\": " << ms(sum.first_frame[0]) << ", "
+      << "\"p95\": " << ms(sum.first_frame[1]) << ", "
+      << "\"p99\": " << ms(sum.first_frame[2]) << "},\n"
+      << "  \"codecs\": {";
+
+    bool first{true};
+    for (const auto& [name, codec]: sum.codecs) {
+      auto count = static_cast<double>(codec.count);
+
+      out << (first ? "\n" : ",\n")
+        << "    \"" << name << "\": {"
+        << "\"images\": " << codec.count << ", "
+        << "\"failed\": " << codec.failed << ", "
+        << "\"decode_ms\": " << ms(codec.decode) / count << ", "
+        << "\"upload_ms\": " << ms(codec.upload) / count << "}";
+      first = false;
+    }
+
+    out << "\n  }\n}\n";
+  }
+
+
+
+
+
+  // navigates through all images, moving on as soon as the current one is shown
+  [[nodiscard]] std::vector<sample> walk(image_source& source) {
+    std::vector<sample> samples;
+
+    auto first = source.current()->path();
+
+    do {
+      auto img   = source.current();
+      auto shown = clock::now();
+
+      while (!img->finished()) {
+        // like the window does on every update, with the main context bound
+        source.collect_textures();
+
+        if (clock::now() - shown > image_timeout) {
+          throw std::runtime_error{"timeout while loading \"" + img->path().string() + "\""};
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds{250});
+      }
+
+      auto timing = img->timing();
+
+      samples.push_back(sample {
+        .codec       = img->codec() ? pixglot::to_string(*img->codec()) : "unknown",
+        .decode      = timing.decode,
+        .upload      = timing.upload,
+        .first_frame = clock::now() - shown,
+        .failed      = img->error() != nullptr
+      });
+
+      logcerr::verbose("\"{}\": first frame after {:.1f} ms", img->path().string(),
+          ms(samples.back().first_frame));
+
+      source.next_image();
+      source.collect_textures();
+    } while (source.current()->path() != first);
+
+    return samples;
+  }
+}
+
+
+
+int main(int argc, char* argv[]) {
+  std::span args{argv, static_cast<size_t>(argc)};
+
+
+
+  bool                                 help       {false};
+  int                                  verbosity  {0};
+  std::optional<std::string>           config_path{};
+  std::optional<uint32_t>              threads    {};
+  std::optional<std::filesystem::path> json_path  {};
+  std::optional<std::filesystem::path> trace_path {};
+
+  std::vector<std::filesystem::path> filenames;
+
+  //NOLINTBEGIN(*-use-designated-initializers)
+  static std::array<option, 7> long_options = {
+    option{"help",    no_argument,       nullptr, 'h'},
+    option{"verbose", no_argument,       nullptr, 'V'},
+    option{"config",  required_argument, nullptr, 'c'},
+    option{"threads", required_argument, nullptr, 't'},
+    option{"json",    required_argument, nullptr, 'j'},
+    option{"trace",   required_argument, nullptr, 1000},
+    option{nullptr,   0,                 nullptr, 0},
+  };
+  //NOLINTEND(*-use-designated-initializers)
+
+  int c {-1};
+  while ((c = getopt_long(args.size(), args.data(), "hVc:t:j:",
+                          long_options.data(), nullptr)) != -1) {
+    switch (c) {
+      case 'h':
+        help = true;
+        break;
+      case 'V':
+        verbosity++;
+        break;
+      case 'c':
+        if (optarg != nullptr) {
+          config_path = std::string{optarg};
+        }
+        break;
+      case 't':
+        if (optarg != nullptr) {
+          std::string_view arg{optarg};
+          size_t count{0};
+
+          if (auto [end, ec] = std::from_chars(arg.begin(), arg.end(), count);
+              ec != std::errc{} || end != arg.end()) {
+            logcerr::error("invalid thread count \"{}\"", arg);
+            return 1;
+          }
+          threads = count;
+        }
+        break;
+      case 'j':
+        if (optarg != nullptr) {
+          json_path = std::filesystem::path{optarg};
+        }
+        break;
+      case 1000:
+        if (optarg != nullptr) {
+          trace_path = std::filesystem::path{optarg};
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  logcerr::output_level(verbosity_level(verbosity));
+
+  while (optind < argc) {
+    filenames.emplace_back(args[optind++]);
+  }
+
+  if (help || filenames.empty()) {
+    print_help();
+    return help ? 0 : 1;
+  }
+
+  int error{};
+
+  try {
+    load_config(config_path);
+
+    auto cfg = global_config();
+    if (threads) {
+      cfg.cache_load_threads = *threads;
+    }
+    // navigation happens as fast as images are shown, which must not count as a burst
+    cfg.il_dwell = std::chrono::milliseconds{0};
+    set_global_config(std::move(cfg));
+
+    if (trace_path) {
+      enable_tracing();
+    }
+
+
+
+    win::headless_egl egl;
+
+    auto main_context = egl.create_context();
+    main_context.bind();
+
+    summary sum;
+
+    {
+      image_source source{{}, filenames, [&egl, &main_context]() {
+        return win::context{
+          std::make_unique<win::context_wayland>(egl.create_context(main_context))};
+      }};
+
+      source.wait_for_listing();
+
+      if (!source) {
+        throw std::runtime_error{"no images found"};
+      }
+
+      auto start   = clock::now();
+      auto samples = walk(source);
+      sum = summarize(samples, clock::now() - start, source.load_threads());
+    }
+
+    if (json_path && *json_path == "-") {
+      print_json(std::cout, sum);
+    } else {
+      print_text(sum);
+
+      if (json_path) {
+        std::ofstream out{*json_path};
+        print_json(out, sum);
+        if (!out) {
+          throw std::runtime_error{"unable to write \"" + json_path->string() + "\""};
+        }
+      }
+    }
+
+    log_statistics();
+
+    if (trace_path) {
+      write_trace(*trace_path);
+    }
+
+  } catch (std::exception& ex) {
+    logcerr::error(ex.what());
+    error = -1;
+  } catch (...) {
+    logcerr::error("...");
+    error = -2;
+  }
+
+
+  return error;
+}
@@ -31,6 +31,12 @@ const config& global_config() {
 
 
 
+void set_global_config(config cfg) {
+  global_state::configuration = std::move(cfg);
+}
+
+
+
 
 
 namespace {
@@ -85,6 +91,10 @@ ICONFIGP_DEFINE_ENUM_LUT(listing_mode,
     "exists",        exists,
     "supported",     supported)
 
+ICONFIGP_DEFINE_ENUM_LUT(watch_granularity,
+    "files",         files,
+    "directories",   directories)
+
 ICONFIGP_DEFINE_ENUM_LUT(path_compare_method,
     "lexicographic", lexicographic,
     "semantic",      semantic)
@@ -130,6 +140,9 @@ config::config(std::string_view content, bool strict) {
     update<float>       (gamma,       root.unique_key("gamma"));
     update<float>       (input_speed, root.unique_key("input-speed"));
 
+    update<watch_granularity>(watch_fs_granularity,
+                              root.unique_key("watch-fs-granularity"));
+
 
 
     if (auto cache = root.subsection("cache")) {
@@ -137,6 +150,15 @@ config::config(std::string_view content, bool strict) {
       update(cache_load_forward,  cache->unique_key("load-forward"));
       update(cache_keep_backward, cache->unique_key("keep-backward"));
       update(cache_load_backward, cache->unique_key("load-backward"));
+      update(cache_read_forward,  cache->unique_key("read-forward"));
+      update(cache_read_backward, cache->unique_key("read-backward"));
+      update(cache_load_threads,  cache->unique_key("load-threads"));
+      update(cache_memory_budget, cache->unique_key("memory-budget"));
+      update(cache_texture_pool,  cache->unique_key("texture-pool"));
+
+      update(cache_disk_cache,            cache->unique_key("disk-cache"));
+      update(cache_disk_cache_size,       cache->unique_key("disk-cache-size"));
+      update(cache_disk_cache_min_decode, cache->unique_key("disk-cache-min-decode-ms"));
 
       cache_keep_forward  = std::max(cache_keep_forward,  cache_load_forward);
       cache_keep_backward = std::max(cache_keep_backward, cache_load_backward);
@@ -191,6 +213,10 @@ config::config(std::string_view content, bool strict) {
       update(fl_multi_dir,              fl->unique_key("multi-dir"));
 
       update(fl_compare_function,       fl->unique_key("sort-mode"));
+
+      update(fl_sniff_threads,          fl->unique_key("sniff-threads"));
+
+      update(fl_watch_quiet,            fl->unique_key("watch-quiet-ms"));
     }
 
 
@@ -204,6 +230,13 @@ config::config(std::string_view content, bool strict) {
       update(il_partial_flush,     il->unique_key("partial-flush"));
 
       update(il_play_available,    il->unique_key("play-available"));
+
+      update(il_dwell,             il->unique_key("dwell-ms"));
+
+      update(il_tile_threshold,    il->unique_key("tile-threshold"));
+      update(il_mipmaps,           il->unique_key("mipmaps"));
+
+      update(il_map_threshold,     il->unique_key("map-threshold"));
     }
 
 
@@ -265,6 +298,7 @@ void config::assert_equal(const config& rhs) const {
 #define ASSEQ(x) assert_eq(x, rhs.x, #x) //NOLINT(*-macro-usage)
   ASSEQ(filter);
   ASSEQ(watch_fs);
+  ASSEQ(watch_fs_granularity);
   ASSEQ(gamma);
   ASSEQ(input_speed);
 
@@ -288,6 +322,14 @@ void config::assert_equal(const config& rhs) const {
   ASSEQ(cache_load_forward);
   ASSEQ(cache_keep_backward);
   ASSEQ(cache_load_backward);
+  ASSEQ(cache_read_forward);
+  ASSEQ(cache_read_backward);
+  ASSEQ(cache_load_threads);
+  ASSEQ(cache_memory_budget);
+  ASSEQ(cache_texture_pool);
+  ASSEQ(cache_disk_cache);
+  ASSEQ(cache_disk_cache_size);
+  ASSEQ(cache_disk_cache_min_decode);
 
   ASSEQ(fl_empty_wd);
   ASSEQ(fl_empty_wd_dir);
@@ -299,6 +341,8 @@ void config::assert_equal(const config& rhs) const {
   ASSEQ(fl_multi_file);
   ASSEQ(fl_multi_dir);
   ASSEQ(fl_compare_function);
+  ASSEQ(fl_sniff_threads);
+  ASSEQ(fl_watch_quiet);
 
   ASSEQ(il_show_loading);
   ASSEQ(il_partial);
@@ -306,5 +350,9 @@ void config::assert_equal(const config& rhs) const {
   ASSEQ(il_partial_interval);
   ASSEQ(il_partial_flush);
   ASSEQ(il_play_available);
+  ASSEQ(il_dwell);
+  ASSEQ(il_tile_threshold);
+  ASSEQ(il_mipmaps);
+  ASSEQ(il_map_threshold);
 #undef ASSEQ
 }
@@ -0,0 +1,434 @@
+#include "phodispl/disk-cache.hpp"
+
+#include "phodispl/mapped-file.hpp"
+#include "phodispl/statistics.hpp"
+#include "phodispl/trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <logcerr/log.hpp>
+
+
+
+namespace {
+  constexpr std::array<char, 8> entry_magic   {'P', 'D', 'C', 'A', 'C', 'H', 'E', '\0'};
+  constexpr uint32_t            entry_version {1};
+  constexpr size_t              data_alignment{64};
+
+  // the source info is stored as is, entries written by builds with a different
+  // layout are rejected by its size
+  static_assert(std::is_trivially_copyable_v<pixglot::frame_source_info>);
+
+
+
+  struct entry_header {
+    std::array<char, 8> magic;
+    uint32_t            version;
+    uint32_t            source_info_size;
+    uint64_t            key_size;
+    uint64_t            frame_count;
+  };
+
+  struct frame_record {
+    uint64_t                   offset;
+    uint64_t                   width;
+    uint64_t                   height;
+    uint64_t                   stride;
+    int64_t                    duration_us;
+    uint32_t                   data_format;
+    uint32_t                   color_channels;
+    uint32_t                   orientation;
+    pixglot::frame_source_info source_info;
+  };
+
+
+
+  template<typename T>
+  [[nodiscard]] std::optional<T> read_at(std::span<const std::byte> data, size_t offset) {
+    if (offset > data.size() || data.size() - offset < sizeof(T)) {
+      return {};
+    }
+
+    T value;
+    std::memcpy(&value, data.subspan(offset).data(), sizeof(T));
+    return value;
+  }
+
+
+
+  template<typename T>
+  void write(std::ostream& out, const T& value) {
+    //NOLINTNEXTLINE(*reinterpret-cast)
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+
+
+  void pad_to(std::ostream& out, size_t& position, size_t alignment) {
+    static constexpr std::array<char, data_alignment> zeros{};
+
+    auto padding = (alignment - position % alignment) % alignment;
+    out.write(zeros.data(), padding);
+    position += padding;
+  }
+
+
+
+  [[nodiscard]] bool valid_format(uint32_t format, uint32_t channels) {
+    switch (static_cast<pixglot::data_format>(format)) {
+      using enum pixglot::data_format;
+      case u8: case u16: case u32: case f16: case f32:
+        break;
+      default:
+        return false;
+    }
+
+    switch (static_cast<pixglot::color_channels>(channels)) {
+      using enum pixglot::color_channels;
+      case gray: case gray_a: case rgb: case rgba:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+
+
+  // the eight symmetries of the square
+  constexpr uint32_t orientation_count{8};
+
+
+
+  [[nodiscard]] bool valid_record(const frame_record& record, size_t data_size) {
+    if (!valid_format(record.data_format, record.color_channels) ||
+        record.orientation >= orientation_count) {
+      return false;
+    }
+
+    auto pixel_size = pixglot::byte_size(pixglot::pixel_format{
+      .format   = static_cast<pixglot::data_format>(record.data_format),
+      .channels = static_cast<pixglot::color_channels>(record.color_channels)
+    });
+
+    if (record.width > record.stride / pixel_size) {
+      return false;
+    }
+
+    return record.offset <= data_size &&
+      (data_size - record.offset) / std::max<uint64_t>(record.stride, 1) >= record.height;
+  }
+
+
+
+  [[nodiscard]] uint64_t fnv1a(std::string_view input) {
+    uint64_t hash{0xcbf29ce484222325};
+    for (char c: input) {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 0x100000001b3;
+    }
+    return hash;
+  }
+}
+
+
+
+
+
+disk_cache::disk_cache(std::filesystem::path directory, size_t capacity) :
+  directory_{std::move(directory)},
+  capacity_ {capacity}
+{
+  std::error_code ec;
+  std::filesystem::create_directories(directory_, ec);
+  if (ec) {
+    logcerr::warn("unable to create disk cache directory \"{}\": {}",
+        directory_.string(), ec.message());
+  }
+}
+
+
+
+std::optional<std::filesystem::path> default_disk_cache_directory() {
+  if (const auto* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != 0) {
+    return std::filesystem::path{xdg} / "phodispl";
+  }
+
+  if (const auto* home = std::getenv("HOME"); home != nullptr && *home != 0) {
+    return std::filesystem::path{home} / ".cache" / "phodispl";
+  }
+
+  return {};
+}
+
+
+
+
+
+std::optional<std::string> disk_cache::key_for(
+    const std::filesystem::path& path,
+    std::string_view             options
+) {
+  std::error_code ec;
+
+  auto absolute = std::filesystem::absolute(path, ec);
+  if (ec) { return {}; }
+
+  auto size = std::filesystem::file_size(absolute, ec);
+  if (ec) { return {}; }
+
+  auto mtime = std::filesystem::last_write_time(absolute, ec);
+  if (ec) { return {}; }
+
+  return absolute.string() + '\n' + std::to_string(size) + '\n'
+    + std::to_string(mtime.time_since_epoch().count()) + '\n' + std::string{options};
+}
+
+
+
+std::filesystem::path disk_cache::entry_path(const std::string& key) const {
+  std::array<char, 17> name{};
+  std::snprintf(name.data(), name.size(), "%016llx",
+      static_cast<unsigned long long>(fnv1a(key)));
+
+  return directory_ / name.data();
+}
+
+
+
+
+
+std::optional<std::vector<source_frame>> disk_cache::lookup(const std::string& key) {
+  trace_zone zone{"disk cache lookup"};
+
+  auto path = entry_path(key);
+
+  std::shared_ptr<mapped_file> file;
+  try {
+    file = std::make_shared<mapped_file>(path);
+  } catch (...) {
+    global_statistics().disk_cache_misses++;
+    return {};
+  }
+
+  auto data = file->data();
+
+  auto header = read_at<entry_header>(data, 0);
+  if (!header || header->magic != entry_magic || header->version != entry_version ||
+      header->source_info_size != sizeof(pixglot::frame_source_info) ||
+      header->key_size != key.size() || data.size() - sizeof(entry_header) < key.size() ||
+      std::memcmp(data.subspan(sizeof(entry_header)).data(), key.data(), key.size()) != 0) {
+
+    global_statistics().disk_cache_misses++;
+    return {};
+  }
+
+  auto corrupt = [&]() -> std::optional<std::vector<source_frame>> {
+    logcerr::warn("removing corrupt disk cache entry \"{}\"", path.string());
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    global_statistics().disk_cache_misses++;
+    return {};
+  };
+
+  size_t position = sizeof(entry_header) + key.size();
+
+  if (header->frame_count > (data.size() - position) / sizeof(frame_record)) {
+    return corrupt();
+  }
+
+  std::vector<source_frame> frames;
+  frames.reserve(header->frame_count);
+
+  for (size_t i = 0; i < header->frame_count; ++i) {
+    auto record = read_at<frame_record>(data, position);
+    position += sizeof(frame_record);
+
+    if (!record || !valid_record(*record, data.size())) {
+      return corrupt();
+    }
+
+    frames.push_back(source_frame{
+      .pixels = {
+        .data   = data.subspan(record->offset, record->stride * record->height),
+        .width  = record->width,
+        .height = record->height,
+        .stride = record->stride,
+        .format = {
+          .format   = static_cast<pixglot::data_format>(record->data_format),
+          .channels = static_cast<pixglot::color_channels>(record->color_channels)
+        },
+        .owner  = file
+      },
+      .properties = {
+        .orientation = static_cast<pixglot::square_isometry>(record->orientation),
+        .source_info = record->source_info,
+        .duration    = std::chrono::microseconds{record->duration_us}
+      }
+    });
+  }
+
+  file->advise(MADV_WILLNEED);
+
+  // the modification time tracks the last use for eviction
+  std::error_code ec;
+  std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+  global_statistics().disk_cache_hits++;
+
+  return frames;
+}
+
+
+
+
+
+void disk_cache::store(const std::string& key, std::span<const source_frame> frames) {
+  trace_zone zone{"disk cache store"};
+
+  // several loader threads may store the same entry at once
+  static std::atomic<uint64_t> store_count{0};
+
+  auto path      = entry_path(key);
+  auto temporary = path;
+  temporary += "." + std::to_string(getpid()) + "." + std::to_string(store_count++) + ".tmp";
+
+  try {
+    std::ofstream out{temporary, std::ios::binary | std::ios::trunc};
+    if (!out) {
+      throw std::runtime_error{"unable to create \"" + temporary.string() + "\""};
+    }
+
+    entry_header header {
+      .magic            = entry_magic,
+      .version          = entry_version,
+      .source_info_size = sizeof(pixglot::frame_source_info),
+      .key_size         = key.size(),
+      .frame_count      = frames.size()
+    };
+
+    write(out, header);
+    out.write(key.data(), static_cast<std::streamsize>(key.size()));
+
+    size_t position = sizeof(entry_header) + key.size() + frames.size() * sizeof(frame_record);
+    position += (data_alignment - position % data_alignment) % data_alignment;
+
+    for (const auto& frame: frames) {
+      auto row_size = frame.pixels.width * pixglot::byte_size(frame.pixels.format);
+
+      write(out, frame_record {
+        .offset         = position,
+        .width          = frame.pixels.width,
+        .height         = frame.pixels.height,
+        .stride         = row_size,
+        .duration_us    = frame.properties.duration.count(),
+        .data_format    = static_cast<uint32_t>(frame.pixels.format.format),
+        .color_channels = static_cast<uint32_t>(frame.pixels.format.channels),
+        .orientation    = static_cast<uint32_t>(frame.properties.orientation),
+        .source_info    = frame.properties.source_info
+      });
+
+      position += row_size * frame.pixels.height;
+      position += (data_alignment - position % data_alignment) % data_alignment;
+    }
+
+    position = sizeof(entry_header) + key.size() + frames.size() * sizeof(frame_record);
+    pad_to(out, position, data_alignment);
+
+    for (const auto& frame: frames) {
+      auto row_size = frame.pixels.width * pixglot::byte_size(frame.pixels.format);
+
+      for (size_t row = 0; row < frame.pixels.height; ++row) {
+        //NOLINTNEXTLINE(*reinterpret-cast)
+        out.write(reinterpret_cast<const char*>(
+              frame.pixels.data.subspan(row * frame.pixels.stride, row_size).data()),
+            static_cast<std::streamsize>(row_size));
+      }
+
+      position += row_size * frame.pixels.height;
+      pad_to(out, position, data_alignment);
+    }
+
+    out.close();
+    if (!out) {
+      throw std::runtime_error{"unable to write \"" + temporary.string() + "\""};
+    }
+
+    std::filesystem::rename(temporary, path);
+
+  } catch (std::exception& ex) {
+    logcerr::warn("unable to store decoded image in disk cache: {}", ex.what());
+
+    std::error_code ec;
+    std::filesystem::remove(temporary, ec);
+    return;
+  }
+
+  global_statistics().disk_cache_stores++;
+
+  evict();
+}
+
+
+
+
+
+void disk_cache::evict() {
+  trace_zone zone{"disk cache eviction"};
+
+  std::lock_guard lock{evict_mutex_};
+
+  struct entry {
+    std::filesystem::file_time_type last_use;
+    size_t                          size;
+    std::filesystem::path           path;
+  };
+
+  std::vector<entry> entries;
+  size_t total{0};
+
+  std::error_code ec;
+  for (const auto& file: std::filesystem::directory_iterator{directory_, ec}) {
+    std::error_code file_ec;
+    if (!file.is_regular_file(file_ec) || file.path().extension() == ".tmp") {
+      continue;
+    }
+
+    auto size     = file.file_size(file_ec);
+    auto last_use = file.last_write_time(file_ec);
+    if (file_ec) {
+      continue;
+    }
+
+    total += size;
+    entries.emplace_back(last_use, size, file.path());
+  }
+
+  if (total <= capacity_) {
+    return;
+  }
+
+  std::ranges::sort(entries, {}, &entry::last_use);
+
+  for (const auto& entry: entries) {
+    if (total <= capacity_) {
+      break;
+    }
+
+    // another instance may have removed it already
+    std::error_code remove_ec;
+    std::filesystem::remove(entry.path, remove_ec);
+    total -= entry.size;
+
+    logcerr::debug("evicted \"{}\" from disk cache", entry.path.string());
+  }
+}
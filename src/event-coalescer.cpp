@@ -0,0 +1,137 @@
+#include "phodispl/event-coalescer.hpp"
+
+#include "phodispl/statistics.hpp"
+
+#include <utility>
+
+#include <logcerr/log.hpp>
+
+
+
+namespace {
+  using action = fs_watcher::action;
+
+  // the effect of an event following earlier ones on the same path
+  [[nodiscard]] std::optional<action> merge(std::optional<action> earlier, action later) {
+    if (!earlier) {
+      return later;
+    }
+
+    switch (*earlier) {
+      case action::added:
+        // a file which came and went is of no interest
+        if (later == action::removed) {
+          return {};
+        }
+        return action::added;
+
+      case action::changed:
+        return later == action::removed ? action::removed : action::changed;
+
+      case action::removed:
+        // replaced by a new file
+        return later == action::removed ? action::removed : action::changed;
+    }
+
+    return later;
+  }
+}
+
+
+
+
+
+event_coalescer::event_coalescer(callback cb, std::chrono::milliseconds quiet_period) :
+  callback_      {std::move(cb)},
+  quiet_period_  {quiet_period},
+
+  deliver_thread_{[this](const std::stop_token& stoken) {
+    logcerr::thread_name("fsev");
+    deliver_loop(stoken);
+  }}
+{}
+
+
+
+
+
+void event_coalescer::push(const std::filesystem::path& path, fs_watcher::action act) {
+  bool first{false};
+
+  {
+    std::lock_guard lock{mutex_};
+
+    auto now = clock::now();
+
+    auto [it, inserted] = pending_.try_emplace(path);
+    if (inserted) {
+      it->second.action = act;
+    } else {
+      it->second.action = merge(it->second.action, act);
+      global_statistics().suppressed_fs_events++;
+    }
+    it->second.last = now;
+
+    first = arrivals_.empty();
+    arrivals_.emplace_back(path, now);
+  }
+
+  // later events never settle before the one the delivery is waiting for
+  if (first) {
+    wakeup_.notify_one();
+  }
+}
+
+
+
+
+
+void event_coalescer::deliver_loop(const std::stop_token& stoken) {
+  // wait a bit longer than necessary, so that events settling shortly after each other
+  // end up in the same batch
+  auto slack = quiet_period_ / 4;
+
+  std::unique_lock lock{mutex_};
+
+  while (!stoken.stop_requested()) {
+    if (arrivals_.empty()) {
+      wakeup_.wait(lock, stoken, [this]() { return !arrivals_.empty(); });
+      continue;
+    }
+
+    auto now = clock::now();
+
+    std::vector<fs_watcher::event> batch;
+
+    while (!arrivals_.empty() && arrivals_.front().second + quiet_period_ <= now) {
+      auto [path, time] = std::move(arrivals_.front());
+      arrivals_.pop_front();
+
+      auto it = pending_.find(path);
+      if (it == pending_.end() || it->second.last != time) {
+        continue;
+      }
+
+      if (it->second.action) {
+        batch.emplace_back(std::move(path), *it->second.action);
+      } else {
+        global_statistics().suppressed_fs_events++;
+      }
+      pending_.erase(it);
+    }
+
+    if (!batch.empty()) {
+      logcerr::debug("delivering {} filesystem event(s)", batch.size());
+
+      if (callback_) {
+        lock.unlock();
+        callback_(std::move(batch));
+        lock.lock();
+      }
+
+    } else if (!arrivals_.empty()) {
+      wakeup_.wait_until(lock, stoken, arrivals_.front().second + quiet_period_ + slack,
+          []() { return false; });
+    }
+  }
+}
@@ -3,9 +3,19 @@
 #include "phodispl/config.hpp"
 #include "phodispl/config-types.hpp"
 #include "phodispl/fs-watcher.hpp"
+#include "phodispl/trace.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <filesystem>
+#include <iterator>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <unordered_set>
+#include <utility>
 
 #include <logcerr/log.hpp>
 
@@ -29,7 +39,7 @@ namespace {
 
 
 file_listing::file_listing(
-    fs_watcher::callback                callback,
+    change_callback                     callback,
     std::vector<std::filesystem::path>  initial_files
 ) :
   initial_files_{std::move(initial_files)},
@@ -64,6 +74,13 @@ file_listing::startup_mode file_listing::determine_startup_mode() const {
 
 
 namespace {
+  // the first batch is kept small so that the first images show up quickly, later ones
+  // grow to keep the overhead of merging them into the cache low
+  constexpr size_t first_batch_size{16};
+  constexpr size_t max_batch_size  {1024};
+
+
+
   [[nodiscard]] bool satisfies(const std::filesystem::path& path, listing_mode mode) {
     switch (mode) {
       case listing_mode::always:
@@ -75,6 +92,59 @@ namespace {
     }
     return false;
   }
+
+
+
+  [[nodiscard]] size_t sniff_thread_count(size_t jobs) {
+    size_t count = global_config().fl_sniff_threads;
+    if (count == 0) {
+      count = std::thread::hardware_concurrency();
+    }
+
+    return std::clamp<size_t>(count, 1, jobs);
+  }
+
+
+
+  // determines the codecs of all files on a bounded number of threads; each result is
+  // written to the slot of its file, so the order of the listing is kept
+  void sniff_parallel(
+      std::span<const std::filesystem::path> paths,
+      std::span<char>                        supported
+  ) {
+    std::atomic<size_t> next{0};
+    std::exception_ptr  error;
+    std::mutex          error_mutex;
+
+    auto work = [&]() {
+      for (size_t i = next++; i < paths.size(); i = next++) {
+        try {
+          supported[i] = satisfies(paths[i], listing_mode::supported) ? 1 : 0;
+        } catch (...) {
+          std::lock_guard lock{error_mutex};
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+      }
+    };
+
+    auto count = sniff_thread_count(paths.size());
+
+    {
+      std::vector<std::jthread> threads;
+      threads.reserve(count - 1);
+      for (size_t i = 1; i < count; ++i) {
+        threads.emplace_back(work);
+      }
+
+      work();
+    }
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
 }
 
 
@@ -122,9 +192,15 @@ void file_listing::clear() {
 
   std::lock_guard lock{mutex_};
 
+  state_ = listing_state::unlisted;
+  deferred_events_.clear();
+
   demotion_candidate_.reset();
   file_list_.clear();
   mode_list_.clear();
+  file_index_.clear();
+  pending_sniffs_.clear();
+  directories_.clear();
 }
 
 
@@ -132,28 +208,49 @@ void file_listing::clear() {
 
 
 void file_listing::demote_initial_file() {
-  std::lock_guard lock{mutex_};
+  std::vector<fs_watcher::event> changes;
 
-  if (!demotion_candidate_) {
-    return;
-  }
+  {
+    std::lock_guard lock{mutex_};
 
-  if (auto it = std::ranges::find(file_list_, *demotion_candidate_);
-      it != file_list_.end()) {
+    if (!demotion_candidate_) {
+      return;
+    }
 
-    auto& mode = mode_list_[it - file_list_.begin()];
+    if (auto it = file_index_.find(*demotion_candidate_); it != file_index_.end()) {
+      auto& mode = mode_list_[it->second];
 
-    mode.first = global_config().fl_single_file_parent_dir;
+      mode.first = global_config().fl_single_file_parent_dir;
 
-    bool was_listed = mode.second;
-    mode.second = satisfies(*it, mode.first);
+      bool was_listed = mode.second;
+      mode.second = satisfies(it->first, mode.first);
 
-    if (!mode.second && was_listed) {
-      invoke_save(callback_, *it, fs_watcher::action::removed);
+      if (!mode.second && was_listed) {
+        changes.emplace_back(it->first, fs_watcher::action::removed);
+      }
     }
+
+    demotion_candidate_.reset();
   }
 
-  demotion_candidate_.reset();
+  if (!changes.empty()) {
+    invoke_save(callback_, std::move(changes));
+  }
+}
+
+
+
+void file_listing::stop_watching() {
+  {
+    std::lock_guard lock{rescan_mutex_};
+    rescans_stopped_ = true;
+  }
+
+  // the rescanner may still add watches
+  rescanner_ = {};
+
+  fs_watcher_.reset();
+  coalescer_.reset();
 }
 
 
@@ -162,10 +259,25 @@ void file_listing::demote_initial_file() {
 
 void file_listing::populate_item_unsafe(
     const std::filesystem::path&        path,
-    listing_mode                        mode
+    listing_mode                        mode,
+    population&                         pop
 ) {
+  if (!file_index_.emplace(path, file_list_.size()).second) {
+    return;
+  }
+
   file_list_.emplace_back(path);
-  mode_list_.emplace_back(mode, satisfies(path, mode));
+
+  if (mode == listing_mode::supported) {
+    pending_sniffs_.emplace_back(file_list_.size() - 1);
+    mode_list_.emplace_back(mode, false);
+  } else {
+    mode_list_.emplace_back(mode, satisfies(path, mode));
+  }
+
+  if (file_list_.size() - pop.reported >= pop.batch_size) {
+    flush_unsafe(pop);
+  }
 }
 
 
@@ -174,18 +286,24 @@ void file_listing::populate_item_unsafe(
 
 void file_listing::populate_directory_unsafe(
     const std::filesystem::path&        path,
-    listing_mode                        mode
+    listing_mode                        mode,
+    population&                         pop
 ) {
   if (std::filesystem::is_directory(path)) {
-    populate_item_unsafe(path, mode);
+    directories_.emplace_back(path);
+    populate_item_unsafe(path, mode, pop);
   }
 
   for (const auto& p: std::filesystem::directory_iterator{path}) {
+    if (pop.stoken.stop_requested()) {
+      return;
+    }
+
     if (p.is_directory()) {
       continue;
     }
 
-    populate_item_unsafe(p.path(), mode);
+    populate_item_unsafe(p.path(), mode, pop);
   }
 }
 
@@ -193,15 +311,45 @@ void file_listing::populate_directory_unsafe(
 
 
 
-std::vector<std::filesystem::path> file_listing::populate() {
+std::vector<std::filesystem::path> file_listing::populate(
+    const std::stop_token& stoken,
+    batch_callback         on_batch
+) {
   if (!fs_watcher_ && global_config().watch_fs) {
-    fs_watcher_.emplace(std::bind_front(&file_listing::on_file_changed, this));
+    coalescer_.emplace(std::bind_front(&file_listing::on_files_changed, this),
+                       global_config().fl_watch_quiet);
+
+    fs_watcher_.emplace([this](const auto& path, fs_watcher::action action) {
+      coalescer_->push(path, action);
+    }, global_config().watch_fs_granularity, [this]() { on_overflow(); });
   }
 
   std::vector<std::filesystem::path> list;
 
-  { std::lock_guard lock{mutex_};
-    populate_lists_unsafe();
+  auto start = std::chrono::steady_clock::now();
+
+  { std::unique_lock lock{mutex_};
+    trace_zone zone{"list files"};
+
+    scanned_at_ = std::filesystem::file_time_type::clock::now();
+    state_      = listing_state::populating;
+
+    population pop {
+      .lock       = lock,
+      .stoken     = stoken,
+      .on_batch   = on_batch,
+      .batch_size = first_batch_size
+    };
+
+    populate_lists_unsafe(pop);
+    flush_unsafe(pop);
+
+    if (stoken.stop_requested()) {
+      logcerr::debug("listing stopped after {} file(s)", file_list_.size());
+      state_ = listing_state::unlisted;
+      deferred_events_.clear();
+      return {};
+    }
 
 
     for (size_t i = 0; i < file_list_.size(); ++i) {
@@ -209,13 +357,32 @@ std::vector<std::filesystem::path> file_listing::populate() {
         list.emplace_back(file_list_[i]);
       }
     }
+
+    logcerr::verbose("listed {} of {} file(s) in {} ms", list.size(), file_list_.size(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start).count());
   }
 
 
+  // the lists do not change until the population has finished
   if (fs_watcher_) {
     fs_watcher_->watch(file_list_);
   }
 
+  std::vector<fs_watcher::event> changes;
+
+  {
+    std::lock_guard lock{mutex_};
+
+    state_  = listing_state::listed;
+    changes = apply_changes_unsafe(std::exchange(deferred_events_, {}));
+  }
+
+  if (!changes.empty()) {
+    logcerr::debug("replaying {} change(s) from while listing", changes.size());
+    invoke_save(callback_, std::move(changes));
+  }
+
   return list;
 }
 
@@ -223,18 +390,22 @@ std::vector<std::filesystem::path> file_listing::populate() {
 
 
 
-void file_listing::populate_lists_unsafe() {
+void file_listing::populate_lists_unsafe(population& pop) {
   switch (determine_startup_mode()) {
     case startup_mode::single_dir:
-      populate_directory_unsafe(initial_files_.front(), global_config().fl_single_dir);
+      populate_directory_unsafe(initial_files_.front(), global_config().fl_single_dir, pop);
       break;
 
     case startup_mode::multi:
       for (const auto& p: initial_files_) {
+        if (pop.stoken.stop_requested()) {
+          break;
+        }
+
         if (std::filesystem::is_directory(p)) {
-          populate_directory_unsafe(p, global_config().fl_multi_dir);
+          populate_directory_unsafe(p, global_config().fl_multi_dir, pop);
         } else {
-          populate_item_unsafe(p, global_config().fl_multi_file);
+          populate_item_unsafe(p, global_config().fl_multi_file, pop);
         }
       }
       break;
@@ -243,17 +414,22 @@ void file_listing::populate_lists_unsafe() {
       const auto& major = initial_files_.front();
 
       if (auto parent = major.parent_path(); std::filesystem::is_directory(parent)) {
-        populate_item_unsafe(parent, global_config().fl_single_file_parent_dir);
+        directories_.emplace_back(parent);
+        populate_item_unsafe(parent, global_config().fl_single_file_parent_dir, pop);
         for (const auto& p: std::filesystem::directory_iterator{major.parent_path()}) {
+          if (pop.stoken.stop_requested()) {
+            return;
+          }
+
           if (p.is_directory() || p.path() == major) {
             continue;
           }
 
-          populate_item_unsafe(p.path(), global_config().fl_single_file_parent_dir);
+          populate_item_unsafe(p.path(), global_config().fl_single_file_parent_dir, pop);
         }
       }
 
-      populate_item_unsafe(major, global_config().fl_single_file);
+      populate_item_unsafe(major, global_config().fl_single_file, pop);
 
       if (global_config().fl_single_file_demote) {
         demotion_candidate_.emplace(major);
@@ -268,7 +444,7 @@ void file_listing::populate_lists_unsafe() {
         break;
       }
 
-      populate_directory_unsafe(wd, global_config().fl_empty_wd_dir);
+      populate_directory_unsafe(wd, global_config().fl_empty_wd_dir, pop);
 
     } break;
 
@@ -281,45 +457,145 @@ void file_listing::populate_lists_unsafe() {
 
 
 
+void file_listing::flush_unsafe(population& pop) {
+  auto pending = std::exchange(pending_sniffs_, {});
+
+  if (!pending.empty()) {
+    std::vector<std::filesystem::path> paths;
+    paths.reserve(pending.size());
+    for (auto index: pending) {
+      paths.emplace_back(file_list_[index]);
+    }
+
+    std::vector<char> supported(pending.size(), 0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // changes are deferred while populating, the lists only grow and the indices
+    // stay valid
+    pop.lock.unlock();
+    sniff_parallel(paths, supported);
+    pop.lock.lock();
+
+    logcerr::debug("determined {} codec(s) on {} thread(s) in {} ms", pending.size(),
+        sniff_thread_count(pending.size()),
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start).count());
+
+    for (size_t i = 0; i < pending.size(); ++i) {
+      mode_list_[pending[i]].second = supported[i] != 0;
+    }
+  }
+
+
+
+  std::vector<std::filesystem::path> batch;
+  for (size_t i = pop.reported; i < file_list_.size(); ++i) {
+    if (mode_list_[i].second && !std::filesystem::is_directory(file_list_[i])) {
+      batch.emplace_back(file_list_[i]);
+    }
+  }
+  pop.reported   = file_list_.size();
+  pop.batch_size = std::min(2 * pop.batch_size, max_batch_size);
+
+  if (!batch.empty() && pop.on_batch && !pop.stoken.stop_requested()) {
+    pop.lock.unlock();
+    pop.on_batch(std::move(batch));
+    pop.lock.lock();
+  }
+}
+
+
+
+
+
 listing_mode file_listing::determine_mode_unsafe(const std::filesystem::path& p) const {
-  std::vector<std::pair<const std::filesystem::path&, size_t>> candidates;
+  // the mode of the outermost listed ancestor (or the path itself)
+  std::optional<size_t> outermost;
 
-  for (size_t i = 0; i < file_list_.size(); ++i) {
-    if (p.native().starts_with(file_list_[i].native())) {
-      candidates.emplace_back(file_list_[i], i);
+  for (auto ancestor = p;; ancestor = ancestor.parent_path()) {
+    if (auto it = file_index_.find(ancestor); it != file_index_.end()) {
+      outermost = it->second;
+    }
+
+    if (!ancestor.has_relative_path()) {
+      break;
     }
   }
 
-  if (candidates.empty()) {
+  if (!outermost) {
     logcerr::warn("unable to determine listing-mode for {}", p.native());
     return listing_mode::supported;
   }
 
-  auto it = std::ranges::min_element(candidates, {},
-      [](const auto& pair) { return pair.first.native().size(); });
+  return mode_list_[*outermost].first;
+}
+
+
+
+
+
+void file_listing::on_files_changed(std::vector<fs_watcher::event> events) {
+  std::vector<fs_watcher::event> changes;
+
+  {
+    std::lock_guard lock{mutex_};
+
+    switch (state_) {
+      case listing_state::unlisted:
+        return;
+
+      case listing_state::populating:
+        std::ranges::move(events, std::back_inserter(deferred_events_));
+        return;
+
+      case listing_state::listed:
+        changes = apply_changes_unsafe(std::move(events));
+        break;
+    }
+  }
 
-  return mode_list_[it->second].first;
+  if (!changes.empty()) {
+    invoke_save(callback_, std::move(changes));
+  }
 }
 
 
 
+std::vector<fs_watcher::event> file_listing::apply_changes_unsafe(
+    std::vector<fs_watcher::event> events
+) {
+  std::vector<fs_watcher::event> changes;
+
+  for (auto& [path, action]: events) {
+    if (auto change = apply_change_unsafe(path, action)) {
+      changes.emplace_back(std::move(path), *change);
+    }
+  }
+
+  return changes;
+}
+
 
 
-void file_listing::on_file_changed(
+std::optional<fs_watcher::action> file_listing::apply_change_unsafe(
     const std::filesystem::path& path,
     fs_watcher::action           action
 ) {
-  std::lock_guard lock{mutex_};
-
   bool listed_before{false};
   bool listed_after {false};
 
-  if (auto it = std::ranges::find(file_list_, path); it != file_list_.end()) {
-    auto ix = it - file_list_.begin();
+  if (auto it = file_index_.find(path); it != file_index_.end()) {
+    auto ix = it->second;
 
     listed_before = mode_list_[ix].second;
 
     if (action == fs_watcher::action::removed) {
+      file_index_.erase(it);
+      if (ix + 1 < file_list_.size()) {
+        file_index_[file_list_.back()] = ix;
+      }
+
       std::swap(file_list_[ix], file_list_.back());
       std::swap(mode_list_[ix], mode_list_.back());
 
@@ -332,24 +608,169 @@ void file_listing::on_file_changed(
 
   } else {
     if (action == fs_watcher::action::removed) {
-      return;
+      return {};
     }
 
     auto mode = determine_mode_unsafe(path);
     listed_after = satisfies(path, mode);
 
+    file_index_.emplace(path, file_list_.size());
     file_list_.emplace_back(path);
     mode_list_.emplace_back(mode, listed_after);
   }
 
 
   if (listed_before && !listed_after) {
-    invoke_save(callback_, path, fs_watcher::action::removed);
+    return fs_watcher::action::removed;
+  }
+
+  if (!listed_before && listed_after) {
+    return fs_watcher::action::added;
+  }
+
+  if (listed_before && listed_after) {
+    return fs_watcher::action::changed;
+  }
+
+  return {};
+}
+
+
+
+
+
+namespace {
+  // file system timestamps lag a bit behind the clock
+  constexpr auto timestamp_margin = std::chrono::seconds{1};
+
+
+
+  [[nodiscard]] bool modified_since(
+      const std::filesystem::path&    path,
+      std::filesystem::file_time_type since
+  ) {
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(path, ec);
+    return !ec && time >= since;
+  }
+}
+
 
-  } else if (!listed_before && listed_after) {
-    invoke_save(callback_, path, fs_watcher::action::added);
 
-  } else if (listed_before && listed_after) {
-    invoke_save(callback_, path, fs_watcher::action::changed);
+void file_listing::rescan(const std::stop_token& stoken) {
+  trace_zone zone{"rescan"};
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::filesystem::path> directories;
+  std::vector<std::filesystem::path> known;
+  std::filesystem::file_time_type    since;
+
+  {
+    std::lock_guard lock{mutex_};
+
+    directories = directories_;
+    known       = file_list_;
+    since       = std::exchange(scanned_at_,
+                    std::filesystem::file_time_type::clock::now()) - timestamp_margin;
+  }
+
+  std::unordered_set<std::filesystem::path> known_set{known.begin(), known.end()};
+  std::unordered_set<std::filesystem::path> directory_set{directories.begin(),
+                                                          directories.end()};
+  std::unordered_set<std::filesystem::path> present;
+
+  std::vector<fs_watcher::event>     events;
+  std::vector<std::filesystem::path> added;
+
+  for (const auto& directory: directories) {
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it{directory, ec}, end;
+         !ec && it != end; it.increment(ec)) {
+
+      if (stoken.stop_requested()) {
+        return;
+      }
+
+      if (it->is_directory(ec)) {
+        continue;
+      }
+
+      const auto& path = it->path();
+      present.emplace(path);
+
+      if (!known_set.contains(path)) {
+        events.emplace_back(path, fs_watcher::action::added);
+        added.emplace_back(path);
+      } else if (modified_since(path, since)) {
+        events.emplace_back(path, fs_watcher::action::changed);
+      }
+    }
+  }
+
+  // files which were not found in a directory, or passed on their own
+  for (const auto& path: known) {
+    if (present.contains(path) || directory_set.contains(path)) {
+      continue;
+    }
+
+    if (std::error_code ec; !std::filesystem::exists(path, ec)) {
+      events.emplace_back(path, fs_watcher::action::removed);
+    } else if (modified_since(path, since)) {
+      events.emplace_back(path, fs_watcher::action::changed);
+    }
   }
+
+  logcerr::verbose("rescan of {} directories found {} change(s) in {} ms",
+      directories.size(), events.size(),
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+
+  if (stoken.stop_requested() || events.empty()) {
+    return;
+  }
+
+  on_files_changed(std::move(events));
+
+  if (fs_watcher_ && !added.empty()) {
+    fs_watcher_->watch(added);
+  }
+}
+
+
+
+void file_listing::on_overflow() {
+  std::lock_guard lock{rescan_mutex_};
+
+  if (rescans_stopped_) {
+    return;
+  }
+
+  // the running rescan may have started before the dropped events happened
+  if (rescanning_) {
+    rescan_pending_ = true;
+    return;
+  }
+
+  rescanning_ = true;
+
+  // the previous rescanner has finished, joining it cannot block
+  rescanner_ = std::jthread{[this](const std::stop_token& stoken) {
+    logcerr::thread_name("scan");
+
+    while (!stoken.stop_requested()) {
+      try {
+        rescan(stoken);
+      } catch (std::exception& ex) {
+        logcerr::error("unable to rescan files: {}", ex.what());
+      }
+
+      std::lock_guard lock{rescan_mutex_};
+      if (!std::exchange(rescan_pending_, false)) {
+        break;
+      }
+    }
+
+    std::lock_guard lock{rescan_mutex_};
+    rescanning_ = false;
+  }};
 }
@@ -0,0 +1,95 @@
+#include "phodispl/file-prefetcher.hpp"
+
+#include "phodispl/statistics.hpp"
+#include "phodispl/trace.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <logcerr/log.hpp>
+
+
+
+namespace {
+  void prefetch_file(const std::filesystem::path& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return;
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+      // only starts the readahead, the pages are read in the background
+      if (posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) == 0) {
+        global_statistics().prefetched_files++;
+        global_statistics().prefetched_bytes += info.st_size;
+      }
+    }
+
+    close(fd);
+  }
+}
+
+
+
+
+
+file_prefetcher::file_prefetcher() :
+  prefetch_thread_{[this](const std::stop_token& stoken) {
+    logcerr::thread_name("read");
+    trace_thread_name("read");
+    prefetch_loop(stoken);
+  }}
+{}
+
+
+
+file_prefetcher::~file_prefetcher() {
+  prefetch_thread_.request_stop();
+}
+
+
+
+
+
+void file_prefetcher::prefetch(std::vector<std::shared_ptr<image>> images) {
+  {
+    std::lock_guard lock{pending_mutex_};
+    pending_.assign(std::make_move_iterator(images.begin()),
+                    std::make_move_iterator(images.end()));
+  }
+  pending_wakeup_.notify_one();
+}
+
+
+
+
+
+void file_prefetcher::prefetch_loop(const std::stop_token& stoken) {
+  while (true) {
+    std::shared_ptr<image> next;
+
+    {
+      std::unique_lock lock{pending_mutex_};
+      if (!pending_wakeup_.wait(lock, stoken, [this]() { return !pending_.empty(); })) {
+        break;
+      }
+
+      next = std::move(pending_.front());
+      pending_.pop_front();
+    }
+
+    if (next->prefetched() || *next) {
+      continue;
+    }
+
+    {
+      trace_zone zone{"prefetch", next->path().native()};
+      prefetch_file(next->path());
+    }
+    next->set_prefetched();
+
+    logcerr::debug("prefetched \"{}\"", next->path().string());
+  }
+}
@@ -1,6 +1,7 @@
 #include "phodispl/formatting.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <filesystem>
@@ -396,3 +397,12 @@ std::u32string format_byte_size(size_t size) {
   num.push_back('B');
   return num;
 }
+
+
+
+std::u32string format_milliseconds(std::chrono::microseconds duration) {
+  auto us  = static_cast<size_t>(std::max<int64_t>(duration.count(), 0));
+  auto num = format_number(us, 1000, 1, format_regular_digit);
+  num.append(U" ms");
+  return num;
+}
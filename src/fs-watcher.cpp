@@ -2,7 +2,9 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include <filesystem>
+#include <vector>
 
 #include <fcntl.h>
 #include <poll.h>
@@ -54,11 +56,17 @@ namespace {
 
 
 
-fs_watcher::fs_watcher(callback&& cb) :
-  callback_    {std::move(cb)},
-  fd_          {create_fd()},
+fs_watcher::fs_watcher(
+    callback&&        cb,
+    watch_granularity granularity,
+    overflow_callback on_overflow
+) :
+  callback_         {std::move(cb)},
+  granularity_      {granularity},
+  overflow_callback_{std::move(on_overflow)},
+  fd_               {create_fd()},
 
-  watch_thread_{[this]() {
+  watch_thread_     {[this]() {
     logcerr::thread_name("fsys");
     logcerr::debug("entering watch loop");
     watch_loop();
@@ -231,9 +239,25 @@ void fs_watcher::watch(std::span<const std::filesystem::path> list) {
 
   std::lock_guard lock{mutex_};
 
+  std::vector<const std::filesystem::path*> files;
+
   for (const auto& path: list) {
-    add_watch(path, true);
+    if (granularity_ == watch_granularity::directories &&
+        !std::filesystem::is_directory(path)) {
+      files.emplace_back(&path);
+    } else {
+      add_watch(path, true);
+    }
+  }
+
+  // only files outside of the watched directories need a watch of their own
+  for (const auto* path: files) {
+    if (!watch_descriptors_.contains(std::filesystem::absolute(*path).parent_path())) {
+      add_watch(*path, true);
+    }
   }
+
+  logcerr::debug("watching {} path(s)", file_watches_.size());
 }
 
 
@@ -245,10 +269,11 @@ void fs_watcher::unwatch() {
 
   std::lock_guard lock{mutex_};
 
-  for (const auto& wi: file_watches_) {
-    inotify_rm_watch(fd_, wi.wd);
+  for (const auto& [wd, item]: file_watches_) {
+    inotify_rm_watch(fd_, wd);
   }
   file_watches_.clear();
+  watch_descriptors_.clear();
 }
 
 
@@ -256,8 +281,12 @@ void fs_watcher::unwatch() {
 
 
 namespace {
-  [[nodiscard]] uint32_t create_mask(const std::filesystem::path& path, bool exp) {
-    if (std::filesystem::is_directory(path)) {
+  [[nodiscard]] uint32_t create_mask(bool directory, bool exp, watch_granularity gran) {
+    if (directory) {
+      if (gran == watch_granularity::directories) {
+        return IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE_SELF | IN_CREATE |
+               IN_CLOSE_WRITE | IN_DELETE;
+      }
       return IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE_SELF | IN_CREATE;
     }
 
@@ -272,14 +301,15 @@ namespace {
 
 
 void fs_watcher::add_watch(const std::filesystem::path& path, bool exp) {
-  auto it = std::ranges::find(file_watches_, path, &watch_item::path);
-  if (it != file_watches_.end()) {
+  auto watch_path = std::filesystem::absolute(path);
+
+  if (watch_descriptors_.contains(watch_path)) {
     return;
   }
 
-  auto watch_path = std::filesystem::absolute(path);
+  bool directory = std::filesystem::is_directory(watch_path);
 
-  if (std::filesystem::is_directory(watch_path)) {
+  if (directory && granularity_ == watch_granularity::files) {
     for (const auto& iter: std::filesystem::directory_iterator(watch_path)) {
       if (!std::filesystem::is_directory(iter.path())) {
         add_watch(iter.path(), false);
@@ -288,12 +318,18 @@ void fs_watcher::add_watch(const std::filesystem::path& path, bool exp) {
   }
 
 
-  auto mask = create_mask(watch_path, exp);
+  auto mask = create_mask(directory, exp, granularity_);
 
   if (int wd = inotify_add_watch(fd_, watch_path.string().c_str(), mask); wd >= 0) {
-    file_watches_.emplace_back( watch_item {
-      .wd   = wd,
-      .path = std::move(watch_path)
+    // another path to the same inode shares its watch descriptor
+    if (file_watches_.contains(wd)) {
+      return;
+    }
+
+    watch_descriptors_.emplace(watch_path, wd);
+    file_watches_.emplace(wd, watch_item {
+      .path      = std::move(watch_path),
+      .directory = directory
     });
   }
 }
@@ -303,12 +339,10 @@ void fs_watcher::add_watch(const std::filesystem::path& path, bool exp) {
 
 
 fs_watcher::watch_iter fs_watcher::remove_watch(watch_iter it) {
-  inotify_rm_watch(fd_, it->wd);
-
-  std::swap(*it, file_watches_.back());
-  file_watches_.pop_back();
+  inotify_rm_watch(fd_, it->first);
 
-  return it;
+  watch_descriptors_.erase(it->second.path);
+  return file_watches_.erase(it);
 }
 
 
@@ -325,7 +359,9 @@ namespace {
       return parent;
     }
 
-    std::string_view name{static_cast<const char*>(event->name), event->len};
+    // the name is padded with null bytes up to len
+    std::string_view name{static_cast<const char*>(event->name),
+                          strnlen(static_cast<const char*>(event->name), event->len)};
 
     return parent / std::filesystem::path(name);
   }
@@ -334,11 +370,19 @@ namespace {
 
 
 void fs_watcher::handle_event(const inotify_event* event) {
-  auto it = std::ranges::find(file_watches_, event->wd, &watch_item::wd);
+  if ((event->mask & IN_Q_OVERFLOW) != 0) {
+    logcerr::warn("inotify event queue overflowed");
+    if (overflow_callback_) {
+      overflow_callback_();
+    }
+    return;
+  }
+
+  auto it = file_watches_.find(event->wd);
 
   if (it != file_watches_.end()) {
-    if (std::filesystem::is_directory(it->path)) {
-      handle_directory_event(it, event->mask, get_path(it->path, event));
+    if (it->second.directory) {
+      handle_directory_event(it, event->mask, get_path(it->second.path, event));
     } else {
       handle_file_event(it, event->mask);
     }
@@ -351,12 +395,12 @@ void fs_watcher::handle_event(const inotify_event* event) {
 
 void fs_watcher::handle_file_event(watch_iter it, uint32_t mask) {
   if (((mask & IN_DELETE_SELF) != 0) ||
-      (((mask & IN_MOVE_SELF) != 0) && !std::filesystem::exists(it->path))) {
-    invoke_callback(it->path, action::removed);
+      (((mask & IN_MOVE_SELF) != 0) && !std::filesystem::exists(it->second.path))) {
+    invoke_callback(it->second.path, action::removed);
     remove_watch(it);
 
   } else if ((mask & IN_CLOSE_WRITE) != 0) {
-    invoke_callback(it->path, action::changed);
+    invoke_callback(it->second.path, action::changed);
   }
 }
 
@@ -369,7 +413,10 @@ void fs_watcher::handle_directory_event(
     uint32_t                     mask,
     const std::filesystem::path& p
 ) {
-  if ((mask & IN_MOVED_TO) != 0) {
+  if (granularity_ == watch_granularity::directories && (mask & IN_DELETE_SELF) == 0) {
+    handle_entry_event(mask, p);
+
+  } else if ((mask & IN_MOVED_TO) != 0) {
     invoke_callback(p, action::changed);
     add_watch(p, false);
 
@@ -378,18 +425,15 @@ void fs_watcher::handle_directory_event(
     add_watch(p, false);
 
   } else if ((mask & IN_MOVED_FROM) != 0) {
-    for (auto jt = file_watches_.begin(); jt != file_watches_.end(); ) {
-      if (jt->path == p) {
-        invoke_callback(p, action::removed);
-        jt = remove_watch(jt);
-      } else {
-        ++jt;
-      }
+    if (auto wd = watch_descriptors_.find(p); wd != watch_descriptors_.end()) {
+      invoke_callback(p, action::removed);
+      remove_watch(file_watches_.find(wd->second));
     }
 
   } else if ((mask & IN_DELETE_SELF) != 0) {
+    // the directory is gone, which is rare enough to justify visiting every watch
     for (auto jt = file_watches_.begin(); jt != file_watches_.end(); ) {
-      if (jt->path.parent_path() == p || jt == it) {
+      if (jt->second.path.parent_path() == p || jt == it) {
         invoke_callback(p, action::removed);
         jt = remove_watch(jt);
       } else {
@@ -398,3 +442,24 @@ void fs_watcher::handle_directory_event(
     }
   }
 }
+
+
+
+
+
+void fs_watcher::handle_entry_event(uint32_t mask, const std::filesystem::path& p) {
+  // subdirectories are never listed
+  if ((mask & IN_ISDIR) != 0) {
+    return;
+  }
+
+  if ((mask & IN_CREATE) != 0) {
+    invoke_callback(p, action::added);
+
+  } else if ((mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0) {
+    invoke_callback(p, action::changed);
+
+  } else if ((mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+    invoke_callback(p, action::removed);
+  }
+}
@@ -0,0 +1,128 @@
+#include "phodispl/gl-format.hpp"
+
+#include "phodispl/config.hpp"
+#include "phodispl/statistics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+
+
+gl_pixel_format gl_format_for(pixglot::pixel_format pf) {
+  using enum pixglot::color_channels;
+  using enum pixglot::data_format;
+
+  gl_pixel_format out{};
+
+  switch (pf.channels) {
+    case gray:   out.format = GL_RED;  out.channels = 1; break;
+    case gray_a: out.format = GL_RG;   out.channels = 2; break;
+    case rgb:    out.format = GL_RGB;  out.channels = 3; break;
+    case rgba:   out.format = GL_RGBA; out.channels = 4; break;
+  }
+
+  constexpr std::array<GLenum, 4> internal_u8 {GL_R8,   GL_RG8,   GL_RGB8,   GL_RGBA8};
+  constexpr std::array<GLenum, 4> internal_u16{GL_R16,  GL_RG16,  GL_RGB16,  GL_RGBA16};
+  constexpr std::array<GLenum, 4> internal_f16{GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F};
+  constexpr std::array<GLenum, 4> internal_f32{GL_R32F, GL_RG32F, GL_RGB32F, GL_RGBA32F};
+
+  auto ix = out.channels - 1;
+
+  switch (pf.format) {
+    case u8:
+      out.type = GL_UNSIGNED_BYTE;  out.internal = internal_u8[ix];  out.channel_size = 1;
+      break;
+    case u16:
+      out.type = GL_UNSIGNED_SHORT; out.internal = internal_u16[ix]; out.channel_size = 2;
+      break;
+    case f16:
+      out.type = GL_HALF_FLOAT;     out.internal = internal_f16[ix]; out.channel_size = 2;
+      break;
+    case u32:
+      out.type = GL_UNSIGNED_INT;   out.internal = internal_f32[ix]; out.channel_size = 4;
+      break;
+    case f32:
+      out.type = GL_FLOAT;          out.internal = internal_f32[ix]; out.channel_size = 4;
+      break;
+  }
+
+  return out;
+}
+
+
+
+
+
+size_t texture_levels(size_t width, size_t height) {
+  if (!global_config().il_mipmaps) {
+    return 1;
+  }
+
+  return std::bit_width(std::max(width, height));
+}
+
+
+
+void generate_mipmaps(const texture_key& key) {
+  if (key.levels <= 1) {
+    return;
+  }
+
+  glGenerateMipmap(GL_TEXTURE_2D);
+
+  auto& stats = global_statistics();
+  stats.mipmap_chains++;
+  stats.mipmap_generated_bytes += byte_size(key) - byte_size({key.width, key.height,
+                                                              key.internal_format, 1});
+}
+
+
+
+
+
+namespace {
+  void set_swizzle(pixglot::color_channels channels) {
+    switch (channels) {
+      case pixglot::color_channels::gray:
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+        break;
+      case pixglot::color_channels::gray_a:
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_GREEN);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+
+
+gl::texture acquire_texture(
+    texture_pool*           pool,
+    const texture_key&      key,
+    pixglot::color_channels channels
+) {
+  // the parameters only depend on the key, a pooled texture has them set already
+  if (pool != nullptr) {
+    if (auto texture = pool->acquire(key)) {
+      texture.bind();
+      return texture;
+    }
+  }
+
+  GLuint name{0};
+  glGenTextures(1, &name);
+  gl::texture texture{name};
+
+  texture.bind();
+  glTexStorage2D(GL_TEXTURE_2D, key.levels, key.internal_format, key.width, key.height);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  set_swizzle(channels);
+
+  return texture;
+}
@@ -5,16 +5,41 @@
 
 #include <algorithm>
 #include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <logcerr/log.hpp>
 
 #include <win/key.hpp>
 
 
 
 namespace {
-  [[nodiscard]] const std::filesystem::path& path_of_shared_image(
-      const std::shared_ptr<image>& img
+  using image_tree = order_statistic_tree<std::shared_ptr<image>>;
+
+
+
+  // index of the first image not ordered before the key
+  [[nodiscard]] size_t position_of(const image_tree& images, const std::string& key) {
+    return images.partition_point([&key](const auto& img) { return img->sort_key() < key; });
+  }
+
+
+
+  [[nodiscard]] size_t position_of(const image_tree& images, const std::filesystem::path& p) {
+    return position_of(images, global_config().fl_compare_function.key(p));
+  }
+
+
+
+  [[nodiscard]] bool is_at(
+      const image_tree&            images,
+      size_t                       index,
+      const std::filesystem::path& path
   ) {
-    return img->path();
+    return index < images.size() && images[index]->path() == path;
   }
 }
 
@@ -31,26 +56,57 @@ std::shared_ptr<image> image_cache::current() const {
 
 
 
+void image_cache::loaded(const std::shared_ptr<image>& img) {
+  // the image may have been unloaded or removed while it was loading
+  if (!*img) {
+    return;
+  }
+
+  if (auto index = position_of(images_, img->sort_key());
+      index >= images_.size() || images_[index] != img) {
+    return;
+  }
+
+  auto bytes = img->texture_bytes();
+  auto [it, inserted] = accounted_.try_emplace(img.get(), bytes);
+
+  if (inserted) {
+    occupancy_.images++;
+  } else {
+    occupancy_.bytes -= std::exchange(it->second, bytes);
+  }
+  occupancy_.bytes += bytes;
+}
+
+
+
 
 
 void image_cache::remove(const std::filesystem::path& path) {
-  auto it = std::ranges::lower_bound(images_, path,
-      global_config().fl_compare_function, &path_of_shared_image);
+  reset_windows();
 
-  if (it == images_.end() || (*it)->path() != path) {
+  auto index = position_of(images_, path);
+
+  if (!is_at(images_, index, path)) {
     return;
   }
 
   if (unload_function_) {
-    unload_unsafe(it - images_.begin());
+    unload_unsafe(index);
+  } else {
+    forget(images_[index].get());
   }
 
-  if (index_ >= static_cast<size_t>(it - images_.begin()) && index_ > 0) {
+  if (index_ >= index && index_ > 0) {
     index_--;
   }
-  images_.erase(it);
+  images_.erase(index);
 
-  ensure_loaded();
+  // the neighbors moved by one toward the removed image
+  loaded_extent_.forward++;
+  loaded_extent_.backward++;
+
+  load_neighbors();
 }
 
 
@@ -61,15 +117,14 @@ namespace {
   [[nodiscard]] std::optional<size_t> load_priority(
       size_t index,
       size_t current,
-      size_t mod
+      size_t mod,
+      size_t lf,
+      size_t lb
   ) {
     if (mod == 0) {
       return {};
     }
 
-    auto lf = global_config().cache_load_forward;
-    auto lb = global_config().cache_load_backward;
-
     auto fw = (mod + index - current) % mod;
     auto bw = (mod + current - index) % mod;
 
@@ -101,7 +156,9 @@ void image_cache::load_maybe(size_t index) const {
     return;
   }
 
-  if (auto prio = load_priority(index, index_, images_.size())) {
+  auto [lf, lb] = load_window();
+
+  if (auto prio = load_priority(index, index_, images_.size(), lf, lb)) {
     load_function_(images_[index], *prio);
   }
 }
@@ -111,30 +168,66 @@ void image_cache::load_maybe(size_t index) const {
 
 
 void image_cache::add(const std::filesystem::path& path) {
-  auto it = std::ranges::lower_bound(images_, path,
-      global_config().fl_compare_function, &path_of_shared_image);
+  reset_windows();
 
-  if (it != images_.end() && (*it)->path() == path) {
-    invalidate(it - images_.begin());
+  auto index = position_of(images_, path);
+
+  if (is_at(images_, index, path)) {
+    invalidate(index);
     return;
   }
 
-  auto inserted = images_.emplace(it, image::create(path));
-  load_maybe(inserted - images_.begin());
+  images_.insert(index, image::create(path));
+
+  if (images_.size() > 1 && index <= index_) {
+    index_++;
+  }
+
+  load_maybe(index);
 
   cleanup(1);
 }
 
 
 
+void image_cache::add(std::span<const std::filesystem::path> paths) {
+  reset_windows();
+
+  auto current = this->current();
+
+  size_t added{0};
+  for (const auto& path: paths) {
+    auto key   = global_config().fl_compare_function.key(path);
+    auto index = position_of(images_, key);
+
+    if (!is_at(images_, index, path)) {
+      images_.insert(index, image::create(path, std::move(key)));
+      added++;
+    }
+  }
+
+  if (added == 0) {
+    return;
+  }
+
+  if (current) {
+    index_ = position_of(images_, current->sort_key());
+  }
+
+  // every image moved by at most the number of added ones
+  cleanup(added);
+  load_neighbors();
+}
+
+
+
 
 
 void image_cache::invalidate(const std::filesystem::path& path) {
-  auto it = std::ranges::lower_bound(images_, path,
-      global_config().fl_compare_function, &path_of_shared_image);
+  auto index = position_of(images_, path);
 
-  if (it != images_.end() && (*it)->path() == path) {
-    invalidate(it - images_.begin());
+  if (is_at(images_, index, path)) {
+    invalidate(index);
   }
 }
 
@@ -151,6 +244,8 @@ void image_cache::invalidate_current() {
 
 
 void image_cache::invalidate(size_t index) {
+  reset_windows();
+
   if (index >= images_.size()) {
     return;
   }
@@ -167,6 +262,8 @@ void image_cache::invalidate(size_t index) {
 
 
 void image_cache::invalidate_all() {
+  reset_windows();
+
   auto mod = images_.size();
 
   if (mod == 0) {
@@ -179,7 +276,7 @@ void image_cache::invalidate_all() {
     }
   }
 
-  ensure_loaded();
+  load_neighbors();
 }
 
 
@@ -197,6 +294,8 @@ void image_cache::load_unsafe(size_t index, size_t priority) const {
 
 
 void image_cache::unload_unsafe(size_t index) const {
+  forget(images_[index].get());
+
   if (*images_[index]) {
     unload_function_(images_[index], index == index_);
   }
@@ -204,16 +303,164 @@ void image_cache::unload_unsafe(size_t index) const {
 
 
 
+void image_cache::forget(const image* img) const {
+  if (auto it = accounted_.find(img); it != accounted_.end()) {
+    occupancy_.images--;
+    occupancy_.bytes -= it->second;
+    accounted_.erase(it);
+  }
+}
+
+
+
+
+
+size_t image_cache::index_at_rank(size_t rank) const {
+  auto mod = images_.size();
+
+  if (rank % 2 == 1) {
+    return (index_ + (rank + 1) / 2) % mod;
+  }
+  return (index_ + mod - rank / 2) % mod;
+}
+
+
+
+namespace {
+  constexpr size_t min_estimate_neighborhood{16};
+}
+
+
+
+neighbor_window image_cache::budget_window() const {
+  auto mod = images_.size();
+  if (mod == 0) {
+    return {0, 0};
+  }
+
+  // images outside of the last window have been unloaded, only look at its surroundings;
+  // the window may grow by this much per evaluation, so that the work stays proportional
+  // to its size instead of the size of the cache
+  auto last_count   = last_budget_window_.forward + last_budget_window_.backward + 1;
+  auto neighborhood = std::min(mod, 2 * last_count + min_estimate_neighborhood);
+
+  size_t known_bytes{0};
+  size_t known_count{0};
+
+  for (size_t rank = 0; rank < neighborhood; ++rank) {
+    if (auto bytes = images_[index_at_rank(rank)]->texture_bytes(); bytes > 0) {
+      known_bytes += bytes;
+      known_count++;
+    }
+  }
+
+  neighbor_window win;
+
+  // until something has been decoded, only the current image is loaded
+  if (known_count > 0) {
+    size_t budget   = size_t{global_config().cache_memory_budget} * 1024 * 1024;
+    size_t estimate = known_bytes / known_count;
+
+    // ranks alternate between forward and backward neighbors like load priorities
+    size_t used  = images_[index_]->texture_bytes();
+    size_t count = 1;
+
+    for (; count < neighborhood; ++count) {
+      auto bytes = images_[index_at_rank(count)]->texture_bytes();
+      used += bytes > 0 ? bytes : estimate;
+
+      if (used > budget) {
+        break;
+      }
+    }
+
+    win = {count / 2, (count - 1) / 2};
+  }
+
+  if (win != last_budget_window_) {
+    logcerr::debug("memory budget window: {} forward, {} backward",
+        win.forward, win.backward);
+    last_budget_window_ = win;
+  }
+
+  return win;
+}
+
+
+
+neighbor_window image_cache::load_window() const {
+  if (load_window_) {
+    return *load_window_;
+  }
+
+  bool budget = global_config().cache_memory_budget > 0;
+
+  auto base = budget ? budget_window() :
+    neighbor_window{global_config().cache_load_forward, global_config().cache_load_backward};
+
+  // with a budget, the window may only be skewed, not stretched
+  auto win = predictor_.predict(base, !budget);
+
+  if (win != last_load_window_) {
+    logcerr::debug("predicted load window: {} forward, {} backward ({:.1f} images/s)",
+        win.forward, win.backward, predictor_.velocity());
+    last_load_window_ = win;
+  }
+
+  load_window_ = win;
+  return win;
+}
+
+
+
+neighbor_window image_cache::read_window() const {
+  auto win = load_window();
+
+  return {
+    std::max<size_t>(win.forward,  global_config().cache_read_forward),
+    std::max<size_t>(win.backward, global_config().cache_read_backward)
+  };
+}
+
+
+
+neighbor_window image_cache::keep_window() const {
+  auto win = load_window();
+
+  if (global_config().cache_memory_budget > 0) {
+    return win;
+  }
+
+  return {
+    std::max<size_t>(win.forward,  global_config().cache_keep_forward),
+    std::max<size_t>(win.backward, global_config().cache_keep_backward)
+  };
+}
+
+
+
 
 
 void image_cache::ensure_loaded() const {
+  reset_windows();
+  load_neighbors();
+}
+
+
+
+void image_cache::load_neighbors() const {
   auto mod = images_.size();
   if (!load_function_ || mod == 0) {
     return;
   }
 
-  auto lf = global_config().cache_load_forward;
-  auto lb = global_config().cache_load_backward;
+  auto window = load_window();
+  auto [lf, lb] = window;
+
+  loaded_extent_ = {
+    std::max(loaded_extent_.forward,  lf),
+    std::max(loaded_extent_.backward, lb)
+  };
 
   if (lf + lb + 1 >= mod) {
     for (size_t i = 0; i < mod; ++i) {
@@ -232,7 +479,42 @@ void image_cache::ensure_loaded() const {
     for (size_t i = 0; i < lf; ++i) {
       load_unsafe((index_ + i + 1) % mod, 2 * i + 1);
     }
+
+    prefetch_outside(window);
+  }
+}
+
+
+
+void image_cache::prefetch_outside(neighbor_window loaded) const {
+  if (!prefetch_function_) {
+    return;
+  }
+
+  auto mod = images_.size();
+  auto [rf, rb] = read_window();
+
+  rf = std::min(rf, mod - 1);
+  rb = std::min(rb, mod - 1 - rf);
+
+  std::vector<std::shared_ptr<image>> images;
+
+  // ordered like load priorities, nearest neighbors first
+  for (size_t i = 1; i <= std::max(rf, rb); ++i) {
+    if (i > loaded.forward && i <= rf) {
+      if (const auto& img = images_[(index_ + i) % mod]; !img->prefetched() && !*img) {
+        images.emplace_back(img);
+      }
+    }
+
+    if (i > loaded.backward && i <= rb) {
+      if (const auto& img = images_[(index_ + mod - i) % mod]; !img->prefetched() && !*img) {
+        images.emplace_back(img);
+      }
+    }
   }
+
+  prefetch_function_(std::move(images));
 }
 
 
@@ -245,18 +527,28 @@ void image_cache::cleanup(size_t margin) const {
     return;
   }
 
-  auto kf = global_config().cache_keep_forward;
-  auto kb = global_config().cache_keep_backward;
+  auto window = keep_window();
+  auto extent = std::exchange(loaded_extent_, window);
 
-  if (kf + kb >= mod) {
+  auto [kf, kb] = window;
+
+  if (kf + kb + 1 >= mod) {
     return;
   }
 
   auto remaining = mod - kf - kb - 1;
 
-  if (remaining >= 2 * margin) {
-    for (size_t i = 0; i < margin; ++i) {
-      unload_unsafe((index_ +        kf + i + 1 ) % mod);
+  // loaded images lie within the previous extent, which moved by at most margin;
+  // only the ranks between its edges and the edges of the window need to be checked
+  auto forward  = std::max(extent.forward,  kf) - kf + margin;
+  auto backward = std::max(extent.backward, kb) - kb + margin;
+
+  if (forward + backward <= remaining) {
+    for (size_t i = 0; i < forward; ++i) {
+      unload_unsafe((index_ + kf + i + 1) % mod);
+    }
+
+    for (size_t i = 0; i < backward; ++i) {
       unload_unsafe((index_ + mod - (kb + i + 1)) % mod);
     }
 
@@ -271,7 +563,25 @@ void image_cache::cleanup(size_t margin) const {
 
 
 
+void image_cache::fit_budget() const {
+  reset_windows();
+
+  if (global_config().cache_memory_budget == 0) {
+    return;
+  }
+
+  // the current image stays, only the edges of the window may have moved
+  cleanup(0);
+  load_neighbors();
+}
+
+
+
+
+
 void image_cache::seek(ssize_t diff) {
+  reset_windows();
+
   ssize_t mod = images_.size();
 
   if (mod == 0) {
@@ -280,9 +590,10 @@ void image_cache::seek(ssize_t diff) {
   }
 
   index_ = ((static_cast<ssize_t>(index_) + diff) % mod + mod) % mod;
+  predictor_.record(diff);
 
   cleanup(std::abs(diff));
-  ensure_loaded();
+  load_neighbors();
 }
 
 
@@ -290,8 +601,7 @@ void image_cache::seek(ssize_t diff) {
 
 
 void image_cache::set(std::span<const std::filesystem::path> new_files) {
-  std::vector<std::shared_ptr<image>> new_images;
-  new_images.reserve(new_files.size());
+  reset_windows();
 
   std::optional<std::filesystem::path> current_path;
   if (index_ < images_.size()) {
@@ -300,33 +610,59 @@ void image_cache::set(std::span<const std::filesystem::path> new_files) {
 
 
 
+  std::vector<std::pair<std::string, const std::filesystem::path*>> files;
+  files.reserve(new_files.size());
   for (const auto& path: new_files) {
-    auto it = std::ranges::lower_bound(images_, path,
-        global_config().fl_compare_function, &path_of_shared_image);
+    files.emplace_back(global_config().fl_compare_function.key(path), &path);
+  }
+  std::ranges::sort(files, {}, &decltype(files)::value_type::first);
+
+
 
-    if (it != images_.end() && (*it)->path() == path) {
-      new_images.emplace_back(std::move(*it));
-      images_.erase(it);
+  // both lists are sorted now, keep the images of files which are still listed
+  auto old_images = images_.release();
+  auto old        = old_images.begin();
+
+  std::vector<std::shared_ptr<image>> new_images;
+  new_images.reserve(files.size());
+
+  for (auto& [key, path]: files) {
+    if (!new_images.empty() && new_images.back()->path() == *path) {
+      continue;
+    }
+
+    while (old != old_images.end() && (*old)->sort_key() < key) {
+      ++old;
+    }
+
+    if (old != old_images.end() && (*old)->path() == *path) {
+      new_images.emplace_back(std::move(*old++));
     } else {
-      new_images.emplace_back(image::create(path));
+      new_images.emplace_back(image::create(*path, std::move(key)));
     }
   }
 
+  images_.assign(std::move(new_images));
+
+  // images which were not moved over are dropped
+  for (const auto& img: old_images) {
+    if (img) {
+      forget(img.get());
+    }
+  }
 
 
-  images_ = std::move(new_images);
-  std::ranges::sort(images_, global_config().fl_compare_function, &path_of_shared_image);
 
   if (current_path) {
-    if (auto it = std::ranges::find(images_, *current_path, &path_of_shared_image);
-        it != images_.end()) {
+    if (auto index = position_of(images_, *current_path);
+        is_at(images_, index, *current_path)) {
 
-      index_ = it - images_.begin();
+      index_ = index;
     } else {
       index_ = 0;
     }
   }
 
   cleanup(images_.size());
-  ensure_loaded();
+  load_neighbors();
 }
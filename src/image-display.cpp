@@ -3,9 +3,13 @@
 #include "phodispl/config.hpp"
 #include "phodispl/config-types.hpp"
 #include "phodispl/formatting.hpp"
+#include "phodispl/trace.hpp"
 
 #include "resources.hpp"
 
+#include <algorithm>
+#include <array>
+
 #include <gl/primitives.hpp>
 
 #include <pixglot/exception.hpp>
@@ -255,7 +259,7 @@ void image_display::on_update() {
 
 
 namespace {
-  [[nodiscard]] std::optional<pixglot::frame_view> current_frame(image* img) {
+  [[nodiscard]] std::shared_ptr<const image_frame> current_frame(image* img) {
     if (img == nullptr) {
       return {};
     }
@@ -275,8 +279,12 @@ namespace {
 
 
 
-  void set_scale_filter(scale_filter filter) {
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, std::to_underlying(filter));
+  void set_scale_filter(scale_filter filter, bool trilinear) {
+    if (trilinear && filter == scale_filter::linear) {
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    } else {
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, std::to_underlying(filter));
+    }
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, std::to_underlying(filter));
   }
 
@@ -293,14 +301,38 @@ namespace {
 
 
 void image_display::on_render() {
+  trace_zone zone{"render"};
+
   shader_.use();
 
   float factor = *crossfade_;
 
+  auto previous_frame = current_frame(previous_.get());
+
+  if ((current_frame_ && current_frame_->tiled()) ||
+      (previous_frame && previous_frame->tiled())) {
+    // tiles need one draw call each, so both images are composed one after another
+    win::set_uniform_mat4(shader_transform_b_, out_of_range_matrix);
+
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    if (previous_frame) {
+      render_single(*previous_frame, 1.f - factor);
+    }
+    if (current_frame_) {
+      // add up both images like the shader does for untiled ones
+      if (previous_frame) {
+        glBlendFunc(GL_ONE, GL_ONE);
+      }
+      render_single(*current_frame_, factor);
+    }
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    return;
+  }
+
   if (current_frame_) {
     glActiveTexture(GL_TEXTURE0);
-    current_frame_->texture().bind();
-    set_scale_filter(scale_filter_);
+    current_frame_->bind();
+    set_scale_filter(scale_filter_, minified_mipmaps(*current_frame_));
 
     win::set_uniform_mat4(shader_transform_a_, matrix_for(*current_frame_));
     crossfade_image(factor, *exposure_, shader_factor_a_);
@@ -308,10 +340,10 @@ void image_display::on_render() {
     win::set_uniform_mat4(shader_transform_a_, out_of_range_matrix);
   }
 
-  if (auto frame = current_frame(previous_.get())) {
+  if (const auto& frame = previous_frame) {
     glActiveTexture(GL_TEXTURE1);
-    frame->texture().bind();
-    set_scale_filter(scale_filter_);
+    frame->bind();
+    set_scale_filter(scale_filter_, minified_mipmaps(*frame));
 
     win::set_uniform_mat4(shader_transform_b_, matrix_for(*frame));
     crossfade_image(1.f - factor, *exposure_, shader_factor_b_);
@@ -328,7 +360,166 @@ void image_display::on_render() {
 
 
 
-float image_display::scale_any(const pixglot::frame_view& f, scale_mode mode) const {
+void image_display::render_single(const image_frame& frame, float factor) {
+  if (frame.tiled()) {
+    render_tiled(frame, factor);
+    return;
+  }
+
+  glActiveTexture(GL_TEXTURE0);
+  frame.bind();
+  set_scale_filter(scale_filter_, minified_mipmaps(frame));
+
+  win::set_uniform_mat4(shader_transform_a_, matrix_for(frame));
+  crossfade_image(factor, *exposure_, shader_factor_a_);
+
+  quad_.draw();
+}
+
+
+
+
+
+namespace {
+  // at most this many tiles are uploaded per rendered frame to keep rendering smooth
+  constexpr size_t max_tile_uploads{4};
+
+
+
+  [[nodiscard]] win::mat4 multiply(const win::mat4& lhs, const win::mat4& rhs) {
+    win::mat4 out{};
+
+    for (size_t row = 0; row < 4; ++row) {
+      for (size_t col = 0; col < 4; ++col) {
+        for (size_t k = 0; k < 4; ++k) {
+          out[4 * row + col] += lhs[4 * row + k] * rhs[4 * k + col];
+        }
+      }
+    }
+
+    return out;
+  }
+
+
+
+  // maps the unit quad onto a region of the frame
+  [[nodiscard]] win::mat4 region_matrix(const image_frame& f, const image_frame::region& r) {
+    float u0 = static_cast<float>(r.x)            / static_cast<float>(f.width());
+    float u1 = static_cast<float>(r.x + r.width)  / static_cast<float>(f.width());
+    float v0 = static_cast<float>(r.y)            / static_cast<float>(f.height());
+    float v1 = static_cast<float>(r.y + r.height) / static_cast<float>(f.height());
+
+    return {
+      u1 - u0, 0.f,     0.f, u0 + u1 - 1.f,
+      0.f,     v1 - v0, 0.f, 1.f - v0 - v1,
+      0.f,     0.f,     1.f, 0.f,
+      0.f,     0.f,     0.f, 1.f,
+    };
+  }
+
+
+
+  struct ndc_rect {
+    float x0, y0, x1, y1;
+  };
+
+  [[nodiscard]] ndc_rect bounding_rect(const win::mat4& m) {
+    ndc_rect rect{1e9f, 1e9f, -1e9f, -1e9f};
+
+    for (float x: {-1.f, 1.f}) {
+      for (float y: {-1.f, 1.f}) {
+        float px = m[0] * x + m[1] * y + m[3];
+        float py = m[4] * x + m[5] * y + m[7];
+
+        rect.x0 = std::min(rect.x0, px); rect.x1 = std::max(rect.x1, px);
+        rect.y0 = std::min(rect.y0, py); rect.y1 = std::max(rect.y1, py);
+      }
+    }
+
+    return rect;
+  }
+
+
+
+  void scissor_to(const ndc_rect& rect) {
+    std::array<GLint, 4> vp{};
+    glGetIntegerv(GL_VIEWPORT, vp.data());
+
+    auto to_pixel = [](float ndc, GLint offset, GLint size) {
+      return offset + static_cast<GLint>((ndc + 1.f) * 0.5f * static_cast<float>(size));
+    };
+
+    GLint x0 = to_pixel(rect.x0, vp[0], vp[2]);
+    GLint y0 = to_pixel(rect.y0, vp[1], vp[3]);
+    GLint x1 = to_pixel(rect.x1, vp[0], vp[2]) + 1;
+    GLint y1 = to_pixel(rect.y1, vp[1], vp[3]) + 1;
+
+    glScissor(x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0));
+  }
+}
+
+
+
+void image_display::render_tiled(const image_frame& frame, float factor) {
+  auto matrix    = matrix_for(frame);
+  auto tiles     = frame.tiles();
+  bool trilinear = minified_mipmaps(frame);
+
+  glActiveTexture(GL_TEXTURE0);
+  crossfade_image(factor, *exposure_, shader_factor_a_);
+  glEnable(GL_SCISSOR_TEST);
+
+  size_t uploads{0};
+  bool   pending{false};
+
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    // the texture (including the border) is mapped onto the stored region, but only the
+    // covered region is drawn
+    auto trafo = multiply(matrix, region_matrix(frame, tiles[i].stored));
+    auto rect  = bounding_rect(multiply(matrix, region_matrix(frame, tiles[i].covered)));
+
+    if (rect.x1 < -1.f || rect.x0 > 1.f || rect.y1 < -1.f || rect.y0 > 1.f) {
+      continue;
+    }
+
+    if (!tiles[i].texture) {
+      if (uploads == max_tile_uploads) {
+        pending = true;
+        continue;
+      }
+      frame.upload_tile(i);
+      uploads++;
+    }
+
+    tiles[i].texture.bind();
+    set_scale_filter(scale_filter_, trilinear);
+
+    win::set_uniform_mat4(shader_transform_a_, trafo);
+    scissor_to(rect);
+
+    quad_.draw();
+  }
+
+  glDisable(GL_SCISSOR_TEST);
+
+  if (pending) {
+    invalidate();
+  }
+}
+
+
+
+
+
+bool image_display::minified_mipmaps(const image_frame& frame) const {
+  return frame.mipmapped() && animated_scale(frame) < 1.f;
+}
+
+
+
+
+
+float image_display::scale_any(const image_frame& f, scale_mode mode) const {
   if (auto* dynamic = std::get_if<dynamic_scale>(&mode)) {
     return scale_dynamic(f, *dynamic);
   }
@@ -361,7 +552,7 @@ float image_display::current_scale(scale_mode mode) const {
 
 
 namespace {
-  [[nodiscard]] vec2<float> real_size(const pixglot::frame_view& f) {
+  [[nodiscard]] vec2<float> real_size(const image_frame& f) {
     vec2<float> size(f.width(), f.height());
 
     if (pixglot::flips_xy(f.orientation())) {
@@ -377,7 +568,7 @@ namespace {
 
 
 float image_display::scale_dynamic(
-    const pixglot::frame_view& f,
+    const image_frame& f,
     dynamic_scale              scale_mode
 ) const {
   auto scale = div(logical_size(), real_size(f));
@@ -428,17 +619,21 @@ namespace {
 
 
 
-win::mat4 image_display::matrix_for(const pixglot::frame_view& f) const {
-  auto size = logical_size();
-
+float image_display::animated_scale(const image_frame& f) const {
   float s_source = scale_any(f, scale_mode_);
   float s_target = scale_any(f, scale_mode_target_);
 
   float factor = position_.clock().factor();
 
-  float s = (1.f - factor) * s_source + factor * s_target;
+  return (1.f - factor) * s_source + factor * s_target;
+}
+
+
+
+win::mat4 image_display::matrix_for(const image_frame& f) const {
+  auto size = logical_size();
 
-  auto scale = s * div(real_size(f), size);
+  auto scale = animated_scale(f) * div(real_size(f), size);
 
   auto pos = mul(div(*position_, size), {2.f, -2.f});
 
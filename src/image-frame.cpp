@@ -0,0 +1,187 @@
+#include "phodispl/image-frame.hpp"
+
+#include "phodispl/config.hpp"
+#include "phodispl/gl-format.hpp"
+
+#include <algorithm>
+
+#include <gl/base.hpp>
+
+
+
+namespace {
+  constexpr size_t tile_size{2048};
+
+
+
+  [[nodiscard]] size_t max_texture_size() {
+    static const size_t size = []() {
+      GLint value{0};
+      glGetIntegerv(GL_MAX_TEXTURE_SIZE, &value);
+      return static_cast<size_t>(std::max(value, GLint{tile_size}));
+    }();
+
+    return size;
+  }
+}
+
+
+
+namespace {
+  [[nodiscard]] texture_key tile_key(const image_frame::tile& tile, GLenum internal) {
+    const auto& [x, y, width, height] = tile.stored;
+    return {width, height, internal, texture_levels(width, height)};
+  }
+
+
+
+  // extends the region by one texel on every side which does not touch the frame edge
+  [[nodiscard]] image_frame::region with_border(
+      const image_frame::region& covered,
+      size_t                     width,
+      size_t                     height
+  ) {
+    auto x0 = covered.x > 0 ? covered.x - 1 : 0;
+    auto y0 = covered.y > 0 ? covered.y - 1 : 0;
+    auto x1 = std::min(covered.x + covered.width  + 1, width);
+    auto y1 = std::min(covered.y + covered.height + 1, height);
+
+    return {x0, y0, x1 - x0, y1 - y0};
+  }
+}
+
+
+
+bool requires_tiling(size_t width, size_t height) {
+  auto limit = std::min<size_t>(global_config().il_tile_threshold, max_texture_size());
+
+  return width > limit || height > limit;
+}
+
+
+
+
+
+image_frame::image_frame(const pixglot::frame_view& view) :
+  width_      {view.width()},
+  height_     {view.height()},
+  orientation_{view.orientation()},
+  source_info_{view.source_info()},
+  view_       {view}
+{}
+
+
+
+image_frame::image_frame(
+    const source_frame&         frame,
+    gl::texture                 texture,
+    const texture_key&          key,
+    std::weak_ptr<texture_pool> pool
+) :
+  width_      {frame.pixels.width},
+  height_     {frame.pixels.height},
+  orientation_{frame.properties.orientation},
+  source_info_{frame.properties.source_info},
+  texture_    {std::move(texture)},
+  texture_key_{key},
+  pool_       {std::move(pool)},
+  mipmapped_  {key.levels > 1}
+{}
+
+
+
+image_frame::image_frame(source_frame frame, std::weak_ptr<texture_pool> pool) :
+  width_      {frame.pixels.width},
+  height_     {frame.pixels.height},
+  orientation_{frame.properties.orientation},
+  source_info_{frame.properties.source_info},
+  pool_       {std::move(pool)},
+  mipmapped_  {global_config().il_mipmaps},
+  tile_source_{std::move(frame.pixels)}
+{
+  // leave room for the borders within the texture size limit
+  constexpr size_t covered_size = tile_size - 2;
+
+  for (size_t y = 0; y < height_; y += covered_size) {
+    for (size_t x = 0; x < width_; x += covered_size) {
+      region covered{x, y,
+          std::min(covered_size, width_ - x), std::min(covered_size, height_ - y)};
+
+      tiles_.emplace_back(covered, with_border(covered, width_, height_), gl::texture{});
+    }
+  }
+}
+
+
+
+image_frame::~image_frame() {
+  auto pool = pool_.lock();
+  if (!pool) {
+    return;
+  }
+
+  if (texture_) {
+    pool->release(texture_key_, std::move(texture_));
+  }
+
+  if (tile_source_.owner) {
+    auto format = gl_format_for(tile_source_.format);
+
+    for (auto& tile: tiles_) {
+      if (tile.texture) {
+        pool->release(tile_key(tile, format.internal), std::move(tile.texture));
+      }
+    }
+  }
+}
+
+
+
+
+
+void image_frame::bind() const {
+  if (view_) {
+    view_->texture().bind();
+  } else {
+    texture_.bind();
+  }
+}
+
+
+
+
+
+void image_frame::upload_tile(size_t index) const {
+  auto& tile = tiles_[index];
+  if (tile.texture) {
+    return;
+  }
+
+  const auto& pixels = tile_source_;
+  auto format = gl_format_for(pixels.format);
+  auto pool   = pool_.lock();
+
+  auto key = tile_key(tile, format.internal);
+  tile.texture = acquire_texture(pool.get(), key, pixels.format.channels);
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  const auto& [x, y, width, height] = tile.stored;
+
+  auto first = pixels.data.subspan(y * pixels.stride + x * format.pixel_size());
+
+  if (pixels.stride % format.pixel_size() == 0) {
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, pixels.stride / format.pixel_size());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+        format.format, format.type, first.data());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+  } else {
+    for (size_t row = 0; row < height; ++row) {
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, width, 1,
+          format.format, format.type, first.subspan(row * pixels.stride).data());
+    }
+  }
+
+  generate_mipmaps(key);
+}
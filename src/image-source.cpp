@@ -1,8 +1,13 @@
 #include "phodispl/image-source.hpp"
 
+#include "phodispl/config.hpp"
 #include "phodispl/file-listing.hpp"
+#include "phodispl/statistics.hpp"
+#include "phodispl/trace.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <filesystem>
 #include <mutex>
 #include <optional>
@@ -21,6 +26,26 @@ namespace {
       std::invoke(std::forward<Fnc>(cb), std::forward<Args>(args)...);
     }
   }
+
+
+
+  [[nodiscard]] size_t load_thread_count() {
+    if (auto count = global_config().cache_load_threads; count > 0) {
+      return count;
+    }
+
+    size_t window = global_config().cache_load_forward +
+                    global_config().cache_load_backward + 1;
+
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, window);
+  }
+
+
+
+  template<typename Ptr>
+  std::intptr_t ptr_to_int(Ptr p) {
+    return reinterpret_cast<std::intptr_t>(p); // NOLINT(*reinterpret-cast)
+  }
 }
 
 
@@ -29,6 +54,17 @@ image_source::image_source(
     callback&&                         cb,
     std::vector<std::filesystem::path> fnames,
     const win::application&            app
+) :
+  image_source{std::move(cb), std::move(fnames),
+    [&app]() { return app.window().share_context(); }}
+{}
+
+
+
+image_source::image_source(
+    callback&&                         cb,
+    std::vector<std::filesystem::path> fnames,
+    context_factory                    share_context
 ) :
   callback_{std::move(cb)},
 
@@ -38,34 +74,52 @@ image_source::image_source(
     },
     [this](const auto& img, bool current) {
       unload_image(img, current);
+    },
+    [this](std::vector<std::shared_ptr<image>> images) {
+      prefetcher_.prefetch(std::move(images));
     }
   },
 
   file_listing_{
-    std::bind_front(&image_source::on_file_changed, this),
+    std::bind_front(&image_source::on_files_changed, this),
     std::move(fnames)
   },
 
-  worker_thread_{
-    [this, context = app.window().share_context()](const std::stop_token& stoken) {
-      logcerr::thread_name("load");
-      context.bind();
-      logcerr::debug("entering load loop");
-      this->work_loop(stoken);
-      logcerr::debug("exiting load loop");
-    }
-  },
+  texture_pool_      {std::make_shared<texture_pool>(
+                        size_t{global_config().cache_texture_pool} * 1024 * 1024)},
+  uploader_          {share_context(), texture_pool_},
+  worker_count_      {load_thread_count()},
 
-  filesystem_context_{app.window().share_context()},
+  filesystem_context_{share_context()},
   main_thread_id_    {std::this_thread::get_id()}
 {
-  std::unique_lock lock{cache_mutex_};
+  logcerr::debug("starting {} load thread(s)", worker_count_);
+
+  worker_threads_.reserve(worker_count_);
+  for (size_t i = 0; i < worker_count_; ++i) {
+    worker_threads_.emplace_back(
+      [this, i, context = share_context()](const std::stop_token& stoken) {
+        auto name = "load" + std::to_string(i);
+        logcerr::thread_name(name);
+        trace_thread_name(name);
+        context.bind();
+        logcerr::debug("entering load loop");
+        this->work_loop(stoken, i);
+        logcerr::debug("exiting load loop");
+      }
+    );
+  }
+
+  {
+    std::lock_guard lock{cache_mutex_};
 
-  if (auto initial = file_listing_.initial_file()) {
-    cache_.add(*initial);
+    if (auto initial = file_listing_.initial_file()) {
+      cache_.add(*initial);
+      invoke_save(callback_, cache_.current(), image_change::next);
+    }
   }
 
-  populate_cache(std::move(lock));
+  start_listing();
 }
 
 
@@ -73,19 +127,24 @@ image_source::image_source(
 
 
 image_source::~image_source() {
-  worker_thread_.request_stop();
+  stop_listing();
+  file_listing_.stop_watching();
+
+  for (auto& worker: worker_threads_) {
+    worker.request_stop();
+  }
 
   {
     std::lock_guard lock{scheduled_images_lock_};
-    if (loading_image_) {
-      (*loading_image_)->abort_loading();
+    for (const auto& [_, img]: loading_images_) {
+      img->abort_loading();
     }
   }
 
   std::this_thread::sleep_for(std::chrono::milliseconds(1));
   {
     std::unique_lock<std::mutex> lock{worker_mutex_};
-    worker_wakeup_.notify_one();
+    worker_wakeup_.notify_all();
   }
 }
 
@@ -94,6 +153,8 @@ image_source::~image_source() {
 
 
 void image_source::unload_image(const std::shared_ptr<image>& image, bool /*current*/) {
+  trace_zone zone{"unload", image->path().native()};
+
   unschedule_image(image);
   image->clear();
 }
@@ -103,42 +164,34 @@ void image_source::unload_image(const std::shared_ptr<image>& image, bool /*curr
 
 
 void image_source::schedule_image(const std::shared_ptr<image>& image, size_t priority) {
+  trace_zone zone{"schedule", image->path().native()};
+
   {
     std::lock_guard lock{scheduled_images_lock_};
 
+    unscheduled_images_.erase(image.get());
+
     if (priority == 0) {
-      for (auto& [prio, _]: scheduled_images_) {
+      // raise every pending priority by one without touching the heap
+      ++schedule_offset_;
+
+      for (auto& [prio, _]: loading_images_) {
         ++prio;
       }
     }
 
-    auto it = std::ranges::find(scheduled_images_, image, &prio_shared_image::second);
-
-    if (it == scheduled_images_.end()) {
-      scheduled_images_.emplace_back(priority, image);
-    } else if (it->first != priority) {
+    if (auto it = std::ranges::find(loading_images_, image, &prio_shared_image::second);
+        it != loading_images_.end()) {
       it->first = priority;
-    } else {
       return;
     }
 
-    std::ranges::sort(scheduled_images_, std::ranges::greater(),
-        &prio_shared_image::first);
-
-    if (!scheduled_images_.empty()) {
-      if (scheduled_images_.back().first == 0 &&
-          loading_image_ &&
-          scheduled_images_.back().second != *loading_image_) {
-
-        (*loading_image_)->abort_loading();
-        aborted_loading_ = true;
-      }
+    if (!scheduled_images_.set(image, static_cast<std::ptrdiff_t>(priority) - schedule_offset_)) {
+      return;
     }
 
-    auto jt = std::ranges::find(unscheduled_images_, image.get());
-    if (jt != unscheduled_images_.end()) {
-      std::swap(*jt, unscheduled_images_.back());
-      unscheduled_images_.pop_back();
+    if (scheduled_images_.top().first + schedule_offset_ == 0) {
+      preempt_loading_unguarded();
     }
   }
 
@@ -150,76 +203,218 @@ void image_source::schedule_image(const std::shared_ptr<image>& image, size_t pr
 
 
 
+void image_source::preempt_loading_unguarded() {
+  if (loading_images_.size() < worker_count_) {
+    return;
+  }
+
+  auto it = std::ranges::max_element(loading_images_, {}, &prio_shared_image::first);
+
+  if (it != loading_images_.end() && it->first > 0) {
+    logcerr::debug("preempting \"{}\" ({})", it->second->path().string(),
+        ptr_to_int(it->second.get()));
+
+    it->second->abort_loading();
+  }
+}
+
+
+
+
+
 void image_source::unschedule_image(const std::shared_ptr<image>& image) {
   std::lock_guard lock{scheduled_images_lock_};
 
-  auto it = std::ranges::find(scheduled_images_, image, &prio_shared_image::second);
-  if (it != scheduled_images_.end()) {
-    if (loading_image_ && *loading_image_ == it->second) {
-      (*loading_image_)->abort_loading();
-      aborted_loading_ = true;
+  bool holding = clock::now() < hold_until_;
+
+  if (scheduled_images_.erase(image)) {
+    if (holding) {
+      global_statistics().avoided_decodes++;
+    }
+
+  } else if (std::ranges::find(loading_images_, image, &prio_shared_image::second)
+             != loading_images_.end()) {
+    unscheduled_images_.emplace(image.get());
+
+    if (holding) {
+      image->abort_loading();
     }
+  }
+}
+
+
+
+
 
-    scheduled_images_.erase(it);
-  } else if (std::ranges::find(unscheduled_images_, image.get())
-             == unscheduled_images_.end()) {
-    unscheduled_images_.emplace_back(image.get());
+void image_source::note_navigation() {
+  auto dwell = global_config().il_dwell;
+  if (dwell.count() == 0) {
+    return;
+  }
+
+  auto now = clock::now();
+
+  if (now - std::exchange(last_navigation_, now) < dwell) {
+    std::lock_guard lock{scheduled_images_lock_};
+
+    if (hold_until_ < now) {
+      logcerr::debug("navigation burst, holding back decoding");
+    }
+    hold_until_ = now + dwell;
   }
 }
 
 
 
+std::optional<image_source::clock::time_point> image_source::held_until() {
+  std::lock_guard lock{scheduled_images_lock_};
+
+  if (clock::now() < hold_until_) {
+    return hold_until_;
+  }
+  return {};
+}
+
 
 
-std::shared_ptr<image> image_source::next_scheduled_image() {
+std::optional<image_source::clock::time_point>
+image_source::pending_prediction_expiry() const {
+  std::lock_guard lock{cache_mutex_};
+
+  if (auto expiry = cache_.prediction_expiry(); expiry && *expiry != refreshed_expiry_) {
+    return expiry;
+  }
+  return {};
+}
+
+
+
+void image_source::refresh_expired_prediction() {
+  std::lock_guard lock{cache_mutex_};
+
+  auto expiry = cache_.prediction_expiry();
+  if (!expiry || *expiry == refreshed_expiry_ || clock::now() <= *expiry) {
+    return;
+  }
+
+  refreshed_expiry_ = *expiry;
+
+  // the navigation burst is over, load the neighbors in both directions again
+  logcerr::debug("navigation settled, updating the load window");
+  cache_.ensure_loaded();
+}
+
+
+
+
+
+bool image_source::work_available() const {
+  std::lock_guard lock{scheduled_images_lock_};
+  return !scheduled_images_.empty() && clock::now() >= hold_until_;
+}
+
+
+
+std::optional<image_source::prio_shared_image> image_source::next_scheduled_image() {
   std::lock_guard<std::mutex> lock{scheduled_images_lock_};
 
-  if (scheduled_images_.empty()) {
+  if (scheduled_images_.empty() || clock::now() < hold_until_) {
     return {};
   }
 
-  auto img = std::move(scheduled_images_.back().second);
-  scheduled_images_.pop_back();
+  auto [prio, img] = scheduled_images_.pop();
 
-  loading_image_ = img;
+  // the offset only grows, so the absolute priority is at least the scheduled one
+  return loading_images_.emplace_back(static_cast<size_t>(prio + schedule_offset_),
+                                      std::move(img));
+}
 
-  return img;
+
+
+
+
+void image_source::finish_loading(const std::shared_ptr<image>& img) {
+  bool requires_recache{false};
+
+  {
+    std::lock_guard lock{scheduled_images_lock_};
+
+    if (auto it = std::ranges::find(loading_images_, img, &prio_shared_image::second);
+        it != loading_images_.end()) {
+      std::swap(*it, loading_images_.back());
+      loading_images_.pop_back();
+    }
+
+    if (unscheduled_images_.erase(img.get()) > 0) {
+      logcerr::debug("dropping image immediately after loading");
+      img->clear();
+
+    } else {
+      // loading was aborted to make room for a more important image
+      requires_recache = !(*img);
+    }
+  }
+
+  std::lock_guard lock{cache_mutex_};
+  cache_.loaded(img);
+
+  if (requires_recache) {
+    logcerr::debug("re-caching after aborting loading");
+    cache_.ensure_loaded();
+
+  } else if (global_config().cache_memory_budget > 0) {
+    // the decoded size is known now, the budget window may grow or shrink
+    cache_.fit_budget();
+  }
 }
 
 
 
 
 
-void image_source::work_loop(const std::stop_token& stoken) {
+void image_source::work_loop(const std::stop_token& stoken, size_t index) {
+  using namespace std::chrono;
+
+  auto start = steady_clock::now();
+  steady_clock::duration busy{0};
+
+  auto utilization = [&]() {
+    auto total = steady_clock::now() - start;
+    if (total.count() == 0) {
+      return 0.f;
+    }
+    return 100.f * static_cast<float>(busy.count()) / static_cast<float>(total.count());
+  };
+
+
+
   while (true) {
     while (!stoken.stop_requested()) {
-      if (auto img = next_scheduled_image()) {
+      if (auto next = next_scheduled_image()) {
+        const auto& [priority, img] = *next;
+
         if (!(*img)) {
-          logcerr::debug("loading \"{}\"({})", img->path().string(),
-              reinterpret_cast<std::intptr_t>(img.get())); // NOLINT(*reinterpret-cast)
-          img->load();
+          logcerr::debug("loading \"{}\"({})", img->path().string(), ptr_to_int(img.get()));
 
-          bool requires_recache{false};
+          // the current image is decoded straight into textures to show partial
+          // progress, everything else goes through the upload pipeline
+          bool direct = priority == 0 &&
+            global_config().il_show_loading && global_config().il_partial;
 
+          auto load_start = steady_clock::now();
           {
-            std::lock_guard lock{scheduled_images_lock_};
-            loading_image_.reset();
-            requires_recache = std::exchange(aborted_loading_, false);
-
-            if (std::ranges::find(unscheduled_images_, img.get())
-                != unscheduled_images_.end()) {
-              logcerr::debug("dropping image immediately after loading");
-              img->clear();
-            }
-            unscheduled_images_.clear();
+            trace_zone zone{"load", img->path().native()};
+            img->load(uploader_, priority, direct);
           }
+          auto load_time = steady_clock::now() - load_start;
+          busy += load_time;
 
-          if (requires_recache) {
-            logcerr::debug("re-caching after aborting loading");
-            std::lock_guard lock{cache_mutex_};
-            cache_.ensure_loaded();
-          }
+          logcerr::debug("worker {}: {} ms for \"{}\", utilization {:.1f}%",
+              index, duration_cast<milliseconds>(load_time).count(),
+              img->path().string(), utilization());
         }
+
+        finish_loading(img);
       } else {
         break;
       }
@@ -229,9 +424,32 @@ void image_source::work_loop(const std::stop_token& stoken) {
       break;
     }
 
+    auto until  = held_until();
+    auto expiry = pending_prediction_expiry();
+
+    // an image may have been scheduled since the queue was found empty, its
+    // notification must not be lost
+    auto has_work = [this]() { return work_available(); };
+
     std::unique_lock<std::mutex> notify_lock{worker_mutex_};
-    worker_wakeup_.wait(notify_lock);
+    if (expiry && (!until || *expiry < *until)) {
+      worker_wakeup_.wait_until(notify_lock, stoken, *expiry, has_work);
+      notify_lock.unlock();
+
+      refresh_expired_prediction();
+    } else if (until) {
+      worker_wakeup_.wait_until(notify_lock, stoken, *until, has_work);
+
+      if (clock::now() >= *until) {
+        // the burst is over, let all workers pick up the held back images
+        worker_wakeup_.notify_all();
+      }
+    } else {
+      worker_wakeup_.wait(notify_lock, stoken, has_work);
+    }
   }
+
+  logcerr::debug("worker {}: total utilization {:.1f}%", index, utilization());
 }
 
 
@@ -246,6 +464,7 @@ void image_source::next_image() {
       return;
     }
 
+    note_navigation();
     cache_.next();
 
     invoke_save(callback_, cache_.current(), image_change::next);
@@ -264,6 +483,7 @@ void image_source::previous_image() {
       return;
     }
 
+    note_navigation();
     cache_.previous();
 
     invoke_save(callback_, cache_.current(), image_change::next);
@@ -286,20 +506,75 @@ void image_source::reload_current() {
 
 
 
-void image_source::populate_cache(std::unique_lock<std::mutex> cache_lock) {
-  auto lock = std::move(cache_lock);
+void image_source::start_listing() {
+  listing_ = true;
 
-  bool first_sent = !cache_.empty();
-  if (first_sent) {
-    invoke_save(callback_, cache_.current(), image_change::next);
+  lister_ = std::jthread{[this](const std::stop_token& stoken) {
+    logcerr::thread_name("list");
+    trace_thread_name("list");
+    list_files(stoken);
+    listing_ = false;
+  }};
+}
+
+
+
+void image_source::stop_listing() {
+  lister_.request_stop();
+  wait_for_listing();
+}
+
+
+
+void image_source::wait_for_listing() {
+  if (lister_.joinable()) {
+    lister_.join();
+  }
+}
+
+
+
+
+
+void image_source::list_files(const std::stop_token& stoken) {
+  try {
+    file_listing_.clear();
+
+    auto files = file_listing_.populate(stoken,
+        std::bind_front(&image_source::add_listed_files, this));
+
+    if (stoken.stop_requested()) {
+      return;
+    }
+
+    std::lock_guard lock{cache_mutex_};
+    win::context_guard context{filesystem_context_};
+
+    // batches arrive unsorted and may contain files which vanished in the meantime
+    auto previous = cache_.current();
+    cache_.set(files);
+
+    if (auto current = cache_.current(); current != previous) {
+      invoke_save(callback_, std::move(current),
+          previous ? image_change::replace_deleted : image_change::next);
+    }
+
+  } catch (std::exception& ex) {
+    logcerr::error("unable to list files: {}", ex.what());
   }
+}
+
+
 
-  file_listing_.clear();
-  auto files = file_listing_.populate();
+void image_source::add_listed_files(std::vector<std::filesystem::path> files) {
+  std::lock_guard lock{cache_mutex_};
+  win::context_guard context{filesystem_context_};
+
+  bool first = cache_.empty();
 
-  cache_.set(files);
+  cache_.add(files);
 
-  if (!first_sent && !cache_.empty()) {
+  if (first && !cache_.empty()) {
     invoke_save(callback_, cache_.current(), image_change::next);
   }
 }
@@ -309,10 +584,14 @@ void image_source::populate_cache(std::unique_lock<std::mutex> cache_lock) {
 
 
 void image_source::reload_file_list() {
-  std::unique_lock lock{cache_mutex_};
+  stop_listing();
+
+  {
+    std::lock_guard lock{cache_mutex_};
+    cache_.invalidate_all();
+  }
 
-  cache_.invalidate_all();
-  populate_cache(std::move(lock));
+  start_listing();
 
   invoke_save(callback_, current(), image_change::reload);
 }
@@ -329,13 +608,32 @@ std::shared_ptr<image> image_source::current() const {
 
 
 
+load_status image_source::status() const {
+  load_status status;
 
+  {
+    std::lock_guard lock{scheduled_images_lock_};
+    status.scheduled = scheduled_images_.size();
+    status.loading   = loading_images_.size();
+  }
 
+  {
+    std::lock_guard lock{cache_mutex_};
+    status.cache = cache_.occupancy();
+  }
 
-void image_source::on_file_changed(
-    const std::filesystem::path& path,
-    fs_watcher::action           action
-) {
+  status.workers      = worker_count_;
+  status.pooled_bytes = texture_pool_->bytes();
+
+  return status;
+}
+
+
+
+
+
+
+void image_source::on_files_changed(std::vector<fs_watcher::event> events) {
   std::lock_guard lock{cache_mutex_};
 
   std::optional<win::context_guard> context;
@@ -343,6 +641,17 @@ void image_source::on_file_changed(
     context.emplace(filesystem_context_);
   }
 
+  for (const auto& [path, action]: events) {
+    on_file_changed_unguarded(path, action);
+  }
+}
+
+
+
+void image_source::on_file_changed_unguarded(
+    const std::filesystem::path& path,
+    fs_watcher::action           action
+) {
   auto current    = cache_.current();
   bool is_current = current && current->path() == path;
 
@@ -1,8 +1,18 @@
 #include "phodispl/image.hpp"
 
 #include "phodispl/config.hpp"
+#include "phodispl/disk-cache.hpp"
+#include "phodispl/trace.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "build-config.h"
 
 #include <gl/base.hpp>
 
@@ -11,6 +21,7 @@
 #include <pixglot/codecs.hpp>
 #include <pixglot/codecs-magic.hpp>
 #include <pixglot/decode.hpp>
+#include <pixglot/pixel-format.hpp>
 
 
 
@@ -26,6 +37,7 @@ namespace {
 
 
 image::~image() {
+  delete_fence_unguarded();
   logcerr::debug("destroying image \"{}\" ({})", path_.string(), ptr_to_int(this));
 }
 
@@ -34,7 +46,13 @@ image::~image() {
 
 
 std::shared_ptr<image> image::create(const std::filesystem::path& path) {
-  std::shared_ptr<image> img{new image(path)};
+  return create(path, global_config().fl_compare_function.key(path));
+}
+
+
+
+std::shared_ptr<image> image::create(const std::filesystem::path& path, std::string key) {
+  std::shared_ptr<image> img{new image(path, std::move(key))};
 
   logcerr::debug("created new image \"{}\" ({})", path.string(), ptr_to_int(img.get()));
 
@@ -55,11 +73,17 @@ void image::clear() {
   error_.reset();
   frames_.clear();
   ptoken_ = {};
+  ++generation_;
+  delete_fence_unguarded();
 
   image_ = {};
+  warnings_.clear();
   codec_ = {};
 
-  file_size_ = 0;
+  file_size_     = 0;
+  texture_bytes_ = 0;
+  prefetched_    = false;
+  timing_        = {};
 }
 
 
@@ -67,7 +91,7 @@ void image::clear() {
 
 
 void image::abort_loading() {
-  if (loading()) {
+  if (loading_started_ && !loading_finished_) {
     ptoken_.stop();
   }
 }
@@ -77,26 +101,156 @@ void image::abort_loading() {
 
 
 namespace {
-  [[nodiscard]] sequence_clock frame_seq_from_image(const pixglot::image& img) {
+  [[nodiscard]] std::vector<std::chrono::microseconds> durations_of(
+      const pixglot::image& img
+  ) {
     std::vector<std::chrono::microseconds> times;
     times.reserve(img.size());
     for (const auto& frame: img.frames()) {
       times.emplace_back(frame.duration());
     }
+    return times;
+  }
+
+
+
+  [[nodiscard]] std::vector<std::chrono::microseconds> durations_of(
+      std::span<const source_frame> frames
+  ) {
+    std::vector<std::chrono::microseconds> times;
+    times.reserve(frames.size());
+    for (const auto& frame: frames) {
+      times.emplace_back(frame.properties.duration);
+    }
+    return times;
+  }
+
+
+
+  [[nodiscard]] size_t texture_bytes_of(const pixglot::image& img) {
+    size_t bytes{0};
+    for (const auto& frame: img.frames()) {
+      bytes += frame.width() * frame.height() * pixglot::byte_size(frame.format());
+    }
+    return bytes;
+  }
+
+
+
+  [[nodiscard]] size_t texture_bytes_of(std::span<const source_frame> frames) {
+    size_t bytes{0};
+    for (const auto& frame: frames) {
+      bytes += frame.pixels.width * frame.pixels.height *
+               pixglot::byte_size(frame.pixels.format);
+    }
+    return bytes;
+  }
+
+
+
+  [[nodiscard]] std::vector<source_frame> source_frames_of(pixglot::image&& img) {
+    auto owner = std::make_shared<pixglot::image>(std::move(img));
+
+    std::vector<source_frame> frames;
+    frames.reserve(owner->size());
+
+    for (const auto& frame: owner->frames()) {
+      const auto& pixels = frame.pixels();
+
+      frames.push_back(source_frame{
+        .pixels = {
+          .data   = pixels.data(),
+          .width  = pixels.width(),
+          .height = pixels.height(),
+          .stride = pixels.stride(),
+          .format = pixels.format(),
+          .owner  = owner
+        },
+        .properties = {
+          .orientation = frame.orientation(),
+          .source_info = frame.source_info(),
+          .duration    = frame.duration()
+        }
+      });
+    }
+
+    return frames;
+  }
+
+
+
+  [[nodiscard]] disk_cache* global_disk_cache() {
+    static const std::unique_ptr<disk_cache> cache = []() -> std::unique_ptr<disk_cache> {
+      if (!global_config().cache_disk_cache) {
+        return {};
+      }
+
+      auto directory = default_disk_cache_directory();
+      if (!directory) {
+        logcerr::warn("unable to determine disk cache directory");
+        return {};
+      }
+
+      return std::make_unique<disk_cache>(std::move(*directory),
+          size_t{global_config().cache_disk_cache_size} * 1024 * 1024);
+    }();
 
-    return sequence_clock{std::span{times}};
+    return cache.get();
+  }
+
+
+
+  // asks the kernel to read large regular files ahead in the background, so that the
+  // buffered reads of the decoder are served from the page cache instead of waiting on
+  // the disk piece by piece; returns immediately, the decoder starts right away
+  [[nodiscard]] bool read_ahead(const std::filesystem::path& path, size_t size) {
+    auto threshold = size_t{global_config().il_map_threshold} * 1024 * 1024;
+
+    if (threshold == 0 || size < threshold) {
+      return false;
+    }
+
+    trace_zone zone{"read ahead", path.native()};
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return false;
+    }
+
+    bool started{false};
+
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+      posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+      started = posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) == 0;
+    }
+
+    close(fd);
+
+    return started;
+  }
+
+
+
+  // everything besides the file itself that changes the decoded pixels
+  [[nodiscard]] std::string decoding_options() {
+    return "gamma=" + std::to_string(global_config().gamma) + ";version=" VERSION_STR;
   }
 }
 
 
 
-void image::load() {
+void image::load(texture_uploader& upl, size_t priority, bool direct) {
   if (loading_started_ || loading_finished_) {
     logcerr::debug("attempting to load \"{}\"", path_.string());
     return;
   }
 
+  load_started_ = std::chrono::steady_clock::now();
+
   try {
+    std::optional<trace_zone> sniff{std::in_place, "sniff", path_.native()};
+
     pixglot::reader reader{path_};
     std::vector<std::byte> buffer(pixglot::recommended_magic_size);
     std::ignore = reader.peek(buffer);
@@ -104,20 +258,46 @@ void image::load() {
 
     file_size_ = reader.size();
 
+    sniff.reset();
+
     loading_started_ = true;
 
-    auto weak_this = weak_from_this();
-    ptoken_.frame_begin_callback([weak_this](const pixglot::frame_view& f) {
-      if (auto self = weak_this.lock()) {
-        { std::lock_guard guard{self->frames_mutex_};
-          self->frames_.emplace_back(f);
+    std::optional<std::string> cache_key;
+    if (auto* cache = global_disk_cache()) {
+      cache_key = disk_cache::key_for(path_, decoding_options());
 
-          self->frame_partial_last_update_ =
-            self->frame_partial_load_begin_ = std::chrono::steady_clock::now();
+      if (cache_key) {
+        if (auto frames = cache->lookup(*cache_key)) {
+          logcerr::debug("found \"{}\" in disk cache", path_.string());
+          upload_frames(upl, std::move(*frames), priority);
+          return;
         }
-        self->damage();
       }
-    });
+    }
+
+    auto* uploader = direct ? nullptr : &upl;
+
+    auto weak_this = weak_from_this();
+    if (uploader == nullptr) {
+      ptoken_.frame_begin_callback([weak_this](const pixglot::frame_view& f) {
+        if (auto self = weak_this.lock()) {
+          if (requires_tiling(f.width(), f.height())) {
+            // a single texture cannot hold this frame, start over with tiles
+            self->requires_tiling_ = true;
+            self->ptoken_.stop();
+            return;
+          }
+
+          { std::lock_guard guard{self->frames_mutex_};
+            self->frames_.emplace_back(std::make_shared<image_frame>(f));
+
+            self->frame_partial_last_update_ =
+              self->frame_partial_load_begin_ = std::chrono::steady_clock::now();
+          }
+          self->damage();
+        }
+      });
+    }
 
     bool animated      {false};
     bool build_sequence{global_config().il_play_available &&
@@ -140,25 +320,61 @@ void image::load() {
     ptoken_.flush_uploads(global_config().il_partial_flush);
 
     pixglot::output_format requested_format;
-    requested_format.storage_type(pixglot::storage_type::gl_texture);
+    requested_format.storage_type(uploader == nullptr ?
+        pixglot::storage_type::gl_texture : pixglot::storage_type::pixel_buffer);
     requested_format.alpha_mode  (pixglot::alpha_mode::premultiplied);
     requested_format.gamma       (global_config().gamma);
 
-    image_.emplace(pixglot::decode(reader, ptoken_.access_token(), requested_format));
+    bool read_ahead_started = read_ahead(path_, file_size_);
+
+    auto decode_start = std::chrono::steady_clock::now();
+    auto decoded = [&]() {
+      trace_zone zone{"decode", path_.native()};
+      return pixglot::decode(reader, ptoken_.access_token(), requested_format);
+    }();
+    auto decode_time = std::chrono::steady_clock::now() - decode_start;
 
-    for (const auto& w: image_->warnings()) {
+    // reading the file is part of the decode time either way
+    logcerr::debug("{} \"{}\": read and decoded {} KiB in {} ms",
+        read_ahead_started ? "read ahead" : "streamed", path_.string(), file_size_ / 1024,
+        std::chrono::duration_cast<std::chrono::milliseconds>(decode_time).count());
+
+    for (const auto& w: decoded.warnings()) {
       logcerr::warn(w);
     }
-    if (auto seq = frame_seq_from_image(*image_); !seq.equals_sequence(frame_sequence_)) {
-      frame_sequence_ = std::move(seq);
-      if (!image_->animated()) {
-        frame_sequence_.pause();
+
+    { std::lock_guard lock{frames_mutex_};
+      warnings_.assign(decoded.warnings().begin(), decoded.warnings().end());
+    }
+
+    if (uploader != nullptr) {
+      auto frames = source_frames_of(std::move(decoded));
+
+      if (!cache_key || decode_time < global_config().cache_disk_cache_min_decode) {
+        upload_frames(*uploader, std::move(frames), priority);
+        return;
       }
+
+      // the copies share the decoded pixels with the frames being uploaded
+      std::vector<source_frame> stored{frames};
+      upload_frames(*uploader, std::move(frames), priority);
+      global_disk_cache()->store(*cache_key, stored);
+      return;
     }
 
+    update_frame_sequence(durations_of(decoded));
+    texture_bytes_ = texture_bytes_of(decoded);
+
+    image_.emplace(std::move(decoded));
+
   } catch (pixglot::decoding_aborted& ex) {
     logcerr::debug(ex.message());
     clear();
+
+    if (std::exchange(requires_tiling_, false)) {
+      logcerr::debug("\"{}\" is too large for direct loading", path_.string());
+      load(upl, priority, false);
+    }
     return;
   } catch (pixglot::base_exception& ex) {
     logcerr::error(ex.message());
@@ -171,7 +387,11 @@ void image::load() {
     error_ = std::make_unique<pixglot::base_exception>("unknown exception");
   }
 
-  glFinish();
+  { std::lock_guard lock{frames_mutex_};
+    set_fence_unguarded(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    timing_.decode = std::chrono::steady_clock::now() - load_started_;
+  }
+  glFlush();
   damage();
 
   logcerr::debug("finished loading \"{}\"", path_.string());
@@ -182,8 +402,151 @@ void image::load() {
 
 
 
-std::optional<pixglot::frame_view> image::current_frame() const {
+void image::upload_frames(
+    texture_uploader&         upl,
+    std::vector<source_frame> frames,
+    size_t                    priority
+) {
+  update_frame_sequence(durations_of(frames));
+
+  texture_bytes_ = texture_bytes_of(frames);
+  if (global_config().il_mipmaps) {
+    texture_bytes_ += texture_bytes_ / 3;
+  }
+
+  size_t generation{0};
+  { std::lock_guard lock{frames_mutex_};
+    generation = generation_;
+
+    upload_started_ = std::chrono::steady_clock::now();
+    timing_.decode  = upload_started_ - load_started_;
+  }
+
+  // decoding is done, the upload thread takes over from here
+  upl.upload(std::move(frames), priority,
+      [weak_this = weak_from_this(), generation]() {
+        auto self = weak_this.lock();
+        if (!self) {
+          return false;
+        }
+        std::lock_guard lock{self->frames_mutex_};
+        return generation == self->generation_;
+      },
+      [weak_this = weak_from_this(), generation](texture_uploader::result result) {
+        if (auto self = weak_this.lock()) {
+          self->finish_upload(generation, std::move(result));
+        }
+      });
+}
+
+
+
+void image::update_frame_sequence(std::vector<std::chrono::microseconds> durations) {
+  if (sequence_clock seq{std::span{durations}}; !seq.equals_sequence(frame_sequence_)) {
+    frame_sequence_ = std::move(seq);
+
+    if (std::ranges::none_of(durations,
+          [](auto d) { return d > std::chrono::microseconds{0}; })) {
+      frame_sequence_.pause();
+    }
+  }
+}
+
+
+
+void image::finish_upload(size_t generation, texture_uploader::result result) {
+  {
+    std::lock_guard lock{frames_mutex_};
+
+    if (generation != generation_) {
+      logcerr::debug("discarding textures of cleared image \"{}\"", path_.string());
+      if (result.fence != nullptr) {
+        glDeleteSync(result.fence);
+      }
+      return;
+    }
+
+    set_fence_unguarded(result.fence);
+
+    if (result.error) {
+      error_ = std::make_unique<pixglot::base_exception>(*result.error);
+    }
+
+    frames_ = std::move(result.frames);
+
+    timing_.upload = std::chrono::steady_clock::now() - upload_started_;
+
+    loading_started_ = loading_finished_ = true;
+  }
+
+  damage();
+
+  logcerr::debug("finished loading \"{}\"", path_.string());
+}
+
+
+
+
+
+void image::set_fence_unguarded(GLsync fence) {
+  delete_fence_unguarded();
+
+  fence_         = fence;
+  fence_waited_  = false;
+  fence_created_ = std::chrono::steady_clock::now();
+}
+
+
+
+bool image::poll_fence_unguarded() const {
+  if (fence_ == nullptr) {
+    return true;
+  }
+
+  if (glClientWaitSync(fence_, 0, 0) == GL_TIMEOUT_EXPIRED) {
+    return false;
+  }
+
+  logcerr::debug("upload fence of \"{}\" signaled after {} ms", path_.string(),
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - fence_created_).count());
+
+  delete_fence_unguarded();
+  return true;
+}
+
+
+
+void image::delete_fence_unguarded() const {
+  if (fence_ != nullptr) {
+    glDeleteSync(fence_);
+    fence_ = nullptr;
+  }
+}
+
+
+
+bool image::finished() const {
+  if (!loading_finished_) {
+    return false;
+  }
+
   std::lock_guard lock{frames_mutex_};
+  return poll_fence_unguarded();
+}
+
+
+
+
+
+std::shared_ptr<const image_frame> image::current_frame() const {
+  std::lock_guard lock{frames_mutex_};
+
+  if (!poll_fence_unguarded() && !fence_waited_) {
+    // let the gpu order rendering after the upload instead of blocking here
+    glWaitSync(fence_, 0, GL_TIMEOUT_IGNORED);
+    fence_waited_ = true;
+  }
 
   if (current_frame_ < frames_.size()) {
     return frames_[current_frame_];
@@ -214,6 +577,10 @@ void image::seek_frame(ssize_t offset) {
 void image::update() {
   std::lock_guard lock(frames_mutex_);
 
+  if (fence_ != nullptr && poll_fence_unguarded()) {
+    damage();
+  }
+
   auto next = frame_sequence_.position_index();
   damage(next != current_frame_);
   current_frame_ = next;
@@ -230,6 +597,7 @@ void image::update() {
           global_config().il_partial_interval) {
         frame_partial_last_update_ = now;
 
+        trace_zone zone{"partial upload", path_.native()};
         ptoken_.upload_available();
       }
     }
@@ -253,9 +621,14 @@ void image::toggle_animation() {
 
 
 std::span<const std::string> image::warnings() const {
-  if (image_) {
-    return image_->warnings();
-  }
+  return warnings_;
+}
 
-  return {};
+
+
+
+
+load_timing image::timing() const {
+  std::lock_guard lock{frames_mutex_};
+  return timing_;
 }
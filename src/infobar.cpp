@@ -5,6 +5,7 @@
 #include "phodispl/fonts.hpp"
 #include "phodispl/formatting.hpp"
 #include "phodispl/image.hpp"
+#include "phodispl/image-frame.hpp"
 
 #include "resources.hpp"
 
@@ -125,7 +126,7 @@ namespace {
 
 
 
-void infobar::set_frame(const pixglot::frame_view& frame) {
+void infobar::set_frame(const image_frame& frame) {
   invalidate(assign_diff(str_format_, format_fsi (frame.source_info())));
   invalidate(assign_diff(str_size_,   format_size(frame.width(), frame.height())));
 }
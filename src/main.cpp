@@ -1,4 +1,6 @@
 #include "phodispl/config.hpp"
+#include "phodispl/statistics.hpp"
+#include "phodispl/trace.hpp"
 #include "phodispl/window.hpp"
 
 #include "build-config.h"
@@ -27,6 +29,7 @@ namespace {
       " -v, --version        show version information and exit\n"
       " -V, --verbose        enable verbose logging (use twice for debug output)\n"
       " -c, --config=PATH    load configuration from PATH\n"
+      "     --trace=PATH     record loading and rendering to PATH (chrome trace format)\n"
       "\n"
       "As input, you can provide ...\n"
       " ... a single file to show the file and phodispl lets you navigate\n"
@@ -125,17 +128,19 @@ int main(int argc, char* argv[]) {
 
   std::optional<std::filesystem::path> desktop_file_path{};
   std::optional<std::filesystem::path> check_default_config{};
+  std::optional<std::filesystem::path> trace_path{};
 
   std::vector<std::filesystem::path> filenames;
 
   //NOLINTBEGIN(*-use-designated-initializers)
-  static std::array<option, 7> long_options = {
+  static std::array<option, 8> long_options = {
     option{"help",                 no_argument,       nullptr, 'h'},
     option{"version",              no_argument,       nullptr, 'v'},
     option{"verbose",              no_argument,       nullptr, 'V'},
     option{"config",               required_argument, nullptr, 'c'},
     option{"desktop-file",         required_argument, nullptr, 1000},
     option{"check-default-config", required_argument, nullptr, 1001},
+    option{"trace",                required_argument, nullptr, 1002},
     option{nullptr,                0,                 nullptr, 0},
   };
   //NOLINTEND(*-use-designated-initializers)
@@ -168,6 +173,11 @@ int main(int argc, char* argv[]) {
           check_default_config = std::filesystem::path{optarg};
         }
         break;
+      case 1002:
+        if (optarg != nullptr) {
+          trace_path = std::filesystem::path{optarg};
+        }
+        break;
       default:
         break;
     }
@@ -206,7 +216,21 @@ int main(int argc, char* argv[]) {
 
     load_config(config_path);
 
-    window{filenames}.run();
+    if (trace_path) {
+      enable_tracing();
+    }
+
+    {
+      window win{filenames};
+      win.run();
+      win.frame_stats().log();
+    }
+
+    log_statistics();
+
+    if (trace_path) {
+      write_trace(*trace_path);
+    }
 
   } catch (std::exception& ex) {
     logcerr::error(ex.what());
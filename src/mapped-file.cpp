@@ -0,0 +1,83 @@
+#include "phodispl/mapped-file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+
+namespace {
+  [[nodiscard]] std::runtime_error system_error(
+      std::string_view             what,
+      const std::filesystem::path& path
+  ) {
+    return std::runtime_error{std::string{what} + " \"" + path.string() + "\": "
+                                + std::strerror(errno)};
+  }
+
+
+
+  class file_descriptor {
+    public:
+      file_descriptor(const file_descriptor&) = delete;
+      file_descriptor(file_descriptor&&)      = delete;
+      file_descriptor& operator=(const file_descriptor&) = delete;
+      file_descriptor& operator=(file_descriptor&&)      = delete;
+
+      explicit file_descriptor(int fd) : fd_{fd} {}
+      ~file_descriptor() { if (fd_ >= 0) { close(fd_); } }
+
+      [[nodiscard]] int get() const { return fd_; }
+
+    private:
+      int fd_;
+  };
+}
+
+
+
+mapped_file::mapped_file(const std::filesystem::path& path) {
+  file_descriptor fd{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (fd.get() < 0) {
+    throw system_error("unable to open", path);
+  }
+
+  struct stat info{};
+  if (fstat(fd.get(), &info) != 0) {
+    throw system_error("unable to stat", path);
+  }
+
+  size_ = info.st_size;
+  if (size_ == 0) {
+    return;
+  }
+
+  auto* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (mapping == MAP_FAILED) {
+    throw system_error("unable to map", path);
+  }
+
+  data_ = static_cast<std::byte*>(mapping);
+}
+
+
+
+mapped_file::~mapped_file() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+
+
+void mapped_file::advise(int advice) const {
+  if (data_ != nullptr) {
+    madvise(data_, size_, advice);
+  }
+}
@@ -0,0 +1,83 @@
+#include "phodispl/navigation-predictor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+
+namespace {
+  // seeks further apart than this do not belong to the same burst
+  constexpr std::chrono::milliseconds idle_timeout{400};
+
+  constexpr float smoothing       {0.5f};
+  constexpr float min_velocity    {2.f};
+  constexpr float stretch_seconds {0.5f};
+  constexpr size_t max_stretch    {32};
+}
+
+
+
+
+
+void navigation_predictor::record(ssize_t diff, clock::time_point now) {
+  auto elapsed = now - last_seek_;
+  last_seek_ = now;
+
+  if (diff == 0 || elapsed > idle_timeout || elapsed <= clock::duration{0}) {
+    // first seek of a burst, the rate is still unknown
+    velocity_ = 0.f;
+    return;
+  }
+
+  auto rate = static_cast<float>(diff) /
+                std::chrono::duration<float>(elapsed).count();
+
+  if (velocity_ == 0.f || (velocity_ > 0.f) != (rate > 0.f)) {
+    velocity_ = rate;
+  } else {
+    velocity_ = smoothing * rate + (1.f - smoothing) * velocity_;
+  }
+}
+
+
+
+float navigation_predictor::velocity(clock::time_point now) const {
+  if (now - last_seek_ > idle_timeout) {
+    return 0.f;
+  }
+  return velocity_;
+}
+
+
+
+std::optional<navigation_predictor::clock::time_point>
+navigation_predictor::expiry() const {
+  if (std::abs(velocity_) < min_velocity) {
+    return {};
+  }
+  return last_seek_ + idle_timeout;
+}
+
+
+
+neighbor_window navigation_predictor::predict(
+    neighbor_window   base,
+    bool              stretch,
+    clock::time_point now
+) const {
+  auto v = velocity(now);
+
+  if (std::abs(v) < min_velocity) {
+    return base;
+  }
+
+  size_t ahead = base.forward + base.backward;
+  if (stretch) {
+    ahead += std::min(static_cast<size_t>(std::abs(v) * stretch_seconds), max_stretch);
+  }
+
+  if (v > 0.f) {
+    return {ahead, 0};
+  }
+  return {0, ahead};
+}
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <compare>
+#include <iterator>
 #include <utility>
 
 
@@ -153,10 +154,92 @@ bool semantic_compare(std::string_view lhs, std::string_view rhs) {
   }
 
   if (lhss.size() != rhss.size()) {
-    return lhss.size() < rhs.size();
+    return lhss.size() < rhss.size();
   }
 
   return std::ranges::lexicographical_compare(lhs, rhs, {}, swap_case, swap_case);
 }
 
 //NOLINTEND(*-use-nullptr)
+
+
+
+
+
+namespace {
+  // separates words and ends the word list, sorts before every character
+  constexpr char key_terminator{0};
+
+
+
+  void append_size(std::string& key, size_t size) {
+    for (size_t shift = 32; shift > 0; shift -= 8) {
+      key.push_back(static_cast<char>((size >> (shift - 8)) & 0xff));
+    }
+  }
+
+
+
+  void append_word(std::string& key, const word& w) {
+    // type 0 is taken by the terminator
+    key.push_back(static_cast<char>(std::to_underlying(w.ctype) + 1));
+
+    switch (w.ctype) {
+      case char_type::number:
+        // longer numbers are larger, equally long ones compare digit by digit
+        append_size(key, w.text.size());
+        key.append(w.text);
+        return;
+
+      case char_type::alpha:
+        // upper case letters stay below the (unchanged) non-ascii bytes
+        for (char c: w.text) {
+          key.push_back(c >= 'a' ? static_cast<char>(c - 'a' + 'A') : c);
+        }
+        break;
+
+      default:
+        key.append(w.text);
+        break;
+    }
+
+    key.push_back(key_terminator);
+  }
+}
+
+
+
+std::string semantic_sort_key(std::string_view str) {
+  std::string key;
+  key.reserve(3 * str.size() + 1);
+
+  auto rest{str};
+  while (!rest.empty()) {
+    append_word(key, next_word_from_nonempty(rest));
+  }
+
+  key.push_back(key_terminator);
+
+  // paths with equal words only differ in case, lower case sorts first
+  std::ranges::transform(str, std::back_inserter(key), swap_case);
+
+  return key;
+}
+
+
+
+std::string lexicographic_sort_key(const std::filesystem::path& path) {
+  std::string key;
+  key.reserve(path.native().size() + 8);
+
+  key.append(path.root_name().native());
+  key.push_back(key_terminator);
+  key.push_back(path.has_root_directory() ? 2 : 1);
+
+  for (const auto& element: path.relative_path()) {
+    key.append(element.native());
+    key.push_back(key_terminator);
+  }
+
+  return key;
+}
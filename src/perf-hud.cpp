@@ -0,0 +1,155 @@
+#include "phodispl/perf-hud.hpp"
+
+#include "phodispl/config.hpp"
+#include "phodispl/fonts.hpp"
+#include "phodispl/formatting.hpp"
+
+#include "resources.hpp"
+
+#include <string>
+#include <string_view>
+
+#include <gl/primitives.hpp>
+
+#include <win/viewport.hpp>
+
+
+
+namespace {
+  constexpr auto sample_interval = std::chrono::milliseconds{250};
+
+  constexpr std::array<std::u32string_view, 6> labels {
+    U"frame", U"decode", U"queue", U"cache", U"textures", U"loaders"
+  };
+
+
+
+  [[nodiscard]] std::u32string ms(perf_hud::duration duration) {
+    return format_milliseconds(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration));
+  }
+
+
+
+  [[nodiscard]] color premultiply(color c, float alpha) {
+    return {c[0] * c[3] * alpha, c[1] * c[3] * alpha, c[2] * c[3] * alpha, c[3] * alpha};
+  }
+}
+
+
+
+
+
+perf_hud::perf_hud(sample_function sample) :
+  sample_{std::move(sample)},
+  quad_  {gl::primitives::quad()},
+  shader_{
+    resources::shader_plane_object_vs_sv(),
+    resources::shader_plane_solid_fs_sv()
+  },
+  shader_trafo_{shader_.uniform("transform")},
+  shader_color_{shader_.uniform("color")}
+{
+  static_assert(labels.size() == line_count);
+}
+
+
+
+
+
+void perf_hud::toggle() {
+  if (locked()) {
+    unlock();
+    hide();
+  } else {
+    next_sample_ = {};
+    lock();
+  }
+}
+
+
+
+
+
+void perf_hud::on_update() {
+  if (!visible() || !sample_) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (now < next_sample_) {
+    return;
+  }
+  next_sample_ = now + sample_interval;
+
+  update_values(sample_());
+}
+
+
+
+void perf_hud::update_values(const sample& s) {
+  std::array<std::u32string, line_count> values {
+    ms(s.frame_time) + U" (every " + ms(s.frame_interval) + U")",
+
+    s.decode ? ms(*s.decode) : U"–",
+
+    to_u32string(s.status.scheduled) + U" scheduled",
+
+    to_u32string(s.status.cache.images) + U" images, " +
+      format_byte_size(s.status.cache.bytes),
+
+    format_byte_size(s.status.cache.bytes + s.status.pooled_bytes) + U" (" +
+      format_byte_size(s.status.pooled_bytes) + U" pooled)",
+
+    to_u32string(s.status.loading) + U" of " + to_u32string(s.status.workers) +
+      U" busy"
+  };
+
+  if (values != values_) {
+    values_ = std::move(values);
+    invalidate();
+  }
+}
+
+
+
+
+
+void perf_hud::on_layout(vec2<std::optional<float>>& size) {
+  float ts = global_config().theme_text_size;
+
+  size.x() = ts * 20.f;
+  size.y() = ts * (1.5f + 1.25f * (line_count - 1) + 1.f);
+}
+
+
+
+
+
+void perf_hud::on_render() {
+  if (!visible()) {
+    return;
+  }
+
+  float ts = global_config().theme_text_size;
+
+  shader_.use();
+  glUniform4f(shader_color_, 0.f, 0.f, 0.f, 0.7f * opacity());
+
+  win::set_uniform_mat4(shader_trafo_,
+      trafo_mat_logical({0.f, 0.f}, logical_size()));
+
+  quad_.draw();
+
+  auto line = logical_position() + ts * vec2{1.0f, 1.5f};
+
+  for (size_t i = 0; i < line_count; ++i) {
+    viewport().draw_string(line, labels[i], font_main, ts,
+        premultiply(global_config().theme_text_color, 0.75f * opacity()));
+
+    viewport().draw_string(line + vec2{ts * 5.f, 0.f}, values_[i], font_main, ts,
+        premultiply(global_config().theme_text_color, opacity()));
+
+    line.y() += ts * 1.25f;
+  }
+}
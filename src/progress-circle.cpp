@@ -4,6 +4,7 @@
 
 #include <chrono>
 #include <cmath>
+#include <numbers>
 
 #include <gl/primitives.hpp>
 
@@ -28,7 +29,14 @@ progress_circle::progress_circle() :
 
 
 void progress_circle::value(float value) {
-  value_ = std::clamp(value, 0.f, 1.f);
+  indeterminate_ = false;
+  value_         = std::clamp(value, 0.f, 1.f);
+}
+
+
+
+void progress_circle::indeterminate() {
+  indeterminate_ = true;
 }
 
 
@@ -36,9 +44,20 @@ void progress_circle::value(float value) {
 
 
 void progress_circle::on_update() {
-  if (visible()) {
-    invalidate();
+  if (!visible()) {
+    return;
   }
+
+  if (indeterminate_) {
+    // one cycle every 2.5 s, reduced before the conversion to keep float precision
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count() % 2500;
+    float phase = static_cast<float>(ms) / 2500.f * 2.f * std::numbers::pi_v<float>;
+
+    value_ = 0.1f + 0.35f * (1.f - std::cos(phase));
+  }
+
+  invalidate();
 }
 
 
@@ -0,0 +1,48 @@
+#include "phodispl/statistics.hpp"
+
+#include <logcerr/log.hpp>
+
+
+
+namespace { namespace global_state {
+  statistics stats;
+}}
+
+
+
+statistics& global_statistics() {
+  return global_state::stats;
+}
+
+
+
+
+
+void log_statistics() {
+  const auto& stats = global_statistics();
+
+  logcerr::debug("waited {} times on upload fences for {} ms in total",
+      stats.fence_waits.load(), stats.fence_wait_us.load() / 1000);
+
+  logcerr::debug("skipped {} decode(s) during navigation bursts",
+      stats.avoided_decodes.load());
+
+  logcerr::debug("texture pool: {} hit(s), {} miss(es)",
+      stats.texture_pool_hits.load(), stats.texture_pool_misses.load());
+
+  logcerr::debug("dropped {} upload(s) of unloaded images",
+      stats.dropped_uploads.load());
+
+  // a running total, released textures are not subtracted
+  logcerr::debug("generated {} mipmap chain(s) with {} MiB in total beyond the base levels",
+      stats.mipmap_chains.load(), stats.mipmap_generated_bytes.load() / (1024 * 1024));
+
+  logcerr::debug("disk cache: {} hit(s), {} miss(es), {} store(s)",
+      stats.disk_cache_hits.load(), stats.disk_cache_misses.load(),
+      stats.disk_cache_stores.load());
+
+  logcerr::debug("prefetched {} file(s) with {} MiB",
+      stats.prefetched_files.load(), stats.prefetched_bytes.load() / (1024 * 1024));
+
+  logcerr::debug("merged away {} filesystem event(s)", stats.suppressed_fs_events.load());
+}
@@ -0,0 +1,158 @@
+#include "phodispl/texture-pool.hpp"
+
+#include "phodispl/statistics.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include <logcerr/log.hpp>
+
+
+
+size_t byte_size(const texture_key& key) {
+  size_t pixel_size{4};
+
+  switch (key.internal_format) {
+    case GL_R8:                                           pixel_size =  1; break;
+    case GL_RG8:   case GL_R16:   case GL_R16F:           pixel_size =  2; break;
+    case GL_RGB8:                                         pixel_size =  3; break;
+    case GL_RGBA8: case GL_RG16:  case GL_RG16F:
+    case GL_R32F:                                         pixel_size =  4; break;
+    case GL_RGB16: case GL_RGB16F:                        pixel_size =  6; break;
+    case GL_RGBA16: case GL_RGBA16F: case GL_RG32F:       pixel_size =  8; break;
+    case GL_RGB32F:                                       pixel_size = 12; break;
+    case GL_RGBA32F:                                      pixel_size = 16; break;
+    default: break;
+  }
+
+  size_t bytes{0};
+  for (size_t level = 0; level < key.levels; ++level) {
+    bytes += std::max<size_t>(key.width  >> level, 1) *
+             std::max<size_t>(key.height >> level, 1) * pixel_size;
+  }
+
+  return bytes;
+}
+
+
+
+
+
+texture_pool::texture_pool(size_t capacity) :
+  capacity_{capacity}
+{}
+
+
+
+texture_pool::~texture_pool() {
+  clear();
+}
+
+
+
+
+
+gl::texture texture_pool::acquire(const texture_key& key) {
+  std::lock_guard lock{mutex_};
+
+  // prefer the most recently released texture
+  auto it = std::ranges::find(entries_.rbegin(), entries_.rend(), key, &entry::key);
+
+  if (it == entries_.rend()) {
+    global_statistics().texture_pool_misses++;
+    return gl::texture{};
+  }
+
+  global_statistics().texture_pool_hits++;
+
+  // the rendering context may still have commands reading from the texture
+  glWaitSync(it->fence, 0, GL_TIMEOUT_IGNORED);
+  glDeleteSync(it->fence);
+
+  auto texture = std::move(it->texture);
+  bytes_ -= byte_size(key);
+  entries_.erase(std::next(it).base());
+
+  return texture;
+}
+
+
+
+void texture_pool::release(const texture_key& key, gl::texture texture) {
+  if (!texture) {
+    return;
+  }
+
+  // the releasing thread may not have a gl context, the texture is deleted or fenced by
+  // the rendering thread
+  std::lock_guard lock{mutex_};
+  released_.emplace_back(key, std::move(texture));
+}
+
+
+
+void texture_pool::collect() {
+  std::lock_guard lock{mutex_};
+
+  if (released_.empty()) {
+    return;
+  }
+
+  auto released = std::exchange(released_, {});
+
+  for (auto& [key, texture, _]: released) {
+    auto size = byte_size(key);
+
+    // dropped textures are deleted on this thread as well
+    if (size > capacity_) {
+      continue;
+    }
+
+    while (bytes_ + size > capacity_ && !entries_.empty()) {
+      drop_oldest_unguarded();
+    }
+
+    entries_.emplace_back(key, std::move(texture),
+                          glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    bytes_ += size;
+  }
+
+  glFlush();
+}
+
+
+
+
+
+void texture_pool::drop_oldest_unguarded() {
+  auto& oldest = entries_.front();
+
+  glDeleteSync(oldest.fence);
+  bytes_ -= byte_size(oldest.key);
+
+  entries_.pop_front();
+}
+
+
+
+void texture_pool::clear() {
+  std::lock_guard lock{mutex_};
+
+  released_.clear();
+
+  if (!entries_.empty()) {
+    logcerr::debug("dropping {} pooled texture(s) ({} MiB)",
+        entries_.size(), bytes_ / (1024 * 1024));
+  }
+
+  while (!entries_.empty()) {
+    drop_oldest_unguarded();
+  }
+}
+
+
+
+size_t texture_pool::bytes() const {
+  std::lock_guard lock{mutex_};
+  return bytes_;
+}
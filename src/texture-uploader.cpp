@@ -0,0 +1,292 @@
+#include "phodispl/texture-uploader.hpp"
+
+#include "phodispl/gl-format.hpp"
+#include "phodispl/statistics.hpp"
+#include "phodispl/trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <gl/base.hpp>
+
+#include <logcerr/log.hpp>
+
+
+
+
+namespace {
+  constexpr size_t pbo_slot_size {16 * 1024 * 1024};
+  constexpr size_t pbo_slot_count{3};
+
+
+
+  // ring of persistently mapped pixel unpack buffers;
+  // while the gpu copies from one slot, the next one is filled
+  class pbo_ring {
+    public:
+      pbo_ring(const pbo_ring&) = delete;
+      pbo_ring(pbo_ring&&)      = delete;
+      pbo_ring& operator=(const pbo_ring&) = delete;
+      pbo_ring& operator=(pbo_ring&&)      = delete;
+
+      pbo_ring() {
+        std::array<GLuint, pbo_slot_count> buffers{};
+        glGenBuffers(buffers.size(), buffers.data());
+
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                                     GL_MAP_COHERENT_BIT;
+
+        for (size_t i = 0; i < slots_.size(); ++i) {
+          auto& slot = slots_[i];
+          slot.buffer = buffers[i];
+
+          glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+          glBufferStorage(GL_PIXEL_UNPACK_BUFFER, pbo_slot_size, nullptr, flags);
+          slot.mapped = static_cast<std::byte*>(
+              glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, pbo_slot_size, flags));
+
+          if (slot.mapped == nullptr) {
+            throw std::runtime_error{"unable to map pixel unpack buffer"};
+          }
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      }
+
+
+
+      ~pbo_ring() {
+        for (auto& slot: slots_) {
+          if (slot.fence != nullptr) {
+            glDeleteSync(slot.fence);
+          }
+
+          glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+          glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+          glDeleteBuffers(1, &slot.buffer);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      }
+
+
+
+      // waits until the gpu finished reading from the next slot and binds it
+      [[nodiscard]] std::byte* acquire() {
+        auto& slot = slots_[next_];
+
+        if (slot.fence != nullptr) {
+          if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            trace_zone zone{"fence wait"};
+            auto start = std::chrono::steady_clock::now();
+
+            while (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                    std::chrono::nanoseconds{std::chrono::seconds{1}}.count())
+                   == GL_TIMEOUT_EXPIRED) {}
+
+            global_statistics().add_fence_wait(std::chrono::steady_clock::now() - start);
+          }
+
+          glDeleteSync(slot.fence);
+          slot.fence = nullptr;
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+
+        return slot.mapped;
+      }
+
+
+
+      // marks the bound slot as in use by the commands issued since acquire()
+      void release() {
+        slots_[next_].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        next_ = (next_ + 1) % slots_.size();
+      }
+
+
+
+    private:
+      struct slot {
+        GLuint     buffer{0};
+        std::byte* mapped{nullptr};
+        GLsync     fence {nullptr};
+      };
+
+      std::array<slot, pbo_slot_count> slots_;
+      size_t                           next_{0};
+  };
+
+
+
+
+
+  [[nodiscard]] std::shared_ptr<image_frame> upload_frame(
+      const source_frame&                  frame,
+      pbo_ring&                            ring,
+      const std::shared_ptr<texture_pool>& pool
+  ) {
+    const auto& pixels = frame.pixels;
+    auto format = gl_format_for(pixels.format);
+
+    size_t row_size = pixels.width * format.pixel_size();
+    if (row_size > pbo_slot_size) {
+      throw std::runtime_error{"image row exceeds upload buffer size"};
+    }
+
+    texture_key key{pixels.width, pixels.height, format.internal,
+                    texture_levels(pixels.width, pixels.height)};
+    auto texture = acquire_texture(pool.get(), key, pixels.format.channels);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    auto   source        = pixels.data;
+    size_t rows_per_slot = pbo_slot_size / row_size;
+
+    for (size_t row = 0; row < pixels.height; row += rows_per_slot) {
+      auto count = std::min(rows_per_slot, pixels.height - row);
+
+      auto* target = ring.acquire();
+      for (size_t r = 0; r < count; ++r) {
+        std::memcpy(target + r * row_size,
+                    source.subspan((row + r) * pixels.stride, row_size).data(),
+                    row_size);
+      }
+
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, pixels.width, count,
+          format.format, format.type, nullptr);
+
+      ring.release();
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    generate_mipmaps(key);
+
+    return std::make_shared<image_frame>(frame, std::move(texture), key, pool);
+  }
+}
+
+
+
+
+
+texture_uploader::texture_uploader(
+    win::context                  context,
+    std::shared_ptr<texture_pool> pool
+) :
+  pool_{std::move(pool)},
+
+  upload_thread_{[this, context = std::move(context)](const std::stop_token& stoken) {
+    logcerr::thread_name("upld");
+    trace_thread_name("upld");
+    context.bind();
+    logcerr::debug("entering upload loop");
+    upload_loop(stoken);
+    logcerr::debug("exiting upload loop");
+  }}
+{}
+
+
+
+texture_uploader::~texture_uploader() {
+  upload_thread_.request_stop();
+}
+
+
+
+
+
+namespace {
+  // orders the heap such that the lowest priority value (the earliest submission among
+  // equal ones) is in front
+  constexpr auto after = [](const auto& lhs, const auto& rhs) {
+    if (lhs.priority != rhs.priority) {
+      return lhs.priority > rhs.priority;
+    }
+    return lhs.sequence > rhs.sequence;
+  };
+}
+
+
+
+void texture_uploader::upload(
+    std::vector<source_frame> source,
+    size_t                    priority,
+    validity&&                valid,
+    callback&&                done
+) {
+  {
+    std::lock_guard lock{jobs_mutex_};
+    jobs_.emplace_back(std::move(source), priority, job_sequence_++,
+                       std::move(valid), std::move(done));
+    std::ranges::push_heap(jobs_, after);
+  }
+  jobs_wakeup_.notify_one();
+}
+
+
+
+
+
+void texture_uploader::upload_loop(const std::stop_token& stoken) {
+  pbo_ring ring;
+
+  while (true) {
+    job next;
+
+    {
+      std::unique_lock lock{jobs_mutex_};
+      if (!jobs_wakeup_.wait(lock, stoken, [this]() { return !jobs_.empty(); })) {
+        break;
+      }
+
+      std::ranges::pop_heap(jobs_, after);
+      next = std::move(jobs_.back());
+      jobs_.pop_back();
+    }
+
+    if (next.valid && !next.valid()) {
+      logcerr::debug("dropping upload of {} frame(s) with priority {}",
+          next.source.size(), next.priority);
+      global_statistics().dropped_uploads++;
+      continue;
+    }
+
+
+
+    result res;
+
+    try {
+      trace_zone zone{"upload"};
+      auto start = std::chrono::steady_clock::now();
+
+      for (auto& frame: next.source) {
+        if (requires_tiling(frame.pixels.width, frame.pixels.height)) {
+          res.frames.emplace_back(std::make_shared<image_frame>(std::move(frame), pool_));
+        } else {
+          res.frames.emplace_back(upload_frame(frame, ring, pool_));
+        }
+      }
+
+      res.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      glFlush();
+
+      logcerr::debug("uploaded {} frame(s) in {} ms", res.frames.size(),
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+
+    } catch (std::exception& ex) {
+      logcerr::error(ex.what());
+      res.error = ex.what();
+    }
+
+    next.source.clear();
+
+    if (next.done) {
+      next.done(std::move(res));
+    }
+  }
+}
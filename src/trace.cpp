@@ -0,0 +1,215 @@
+#include "phodispl/trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <unistd.h>
+
+#include <logcerr/log.hpp>
+
+
+
+namespace {
+  constexpr size_t trace_capacity{1 << 16};
+  constexpr size_t detail_size   {64};
+
+
+
+  struct trace_event {
+    // odd while the slot is being written
+    std::atomic<uint64_t>          sequence{0};
+
+    const char*                    name{nullptr};
+    std::array<char, detail_size>  detail{};
+    uint32_t                       thread{0};
+    int64_t                        begin_ns{0};
+    int64_t                        duration_ns{0};
+  };
+
+
+
+  // writers claim slots with a single atomic increment and never wait for each
+  // other; once the buffer is full, the oldest events are overwritten
+  struct trace_buffer {
+    std::unique_ptr<std::array<trace_event, trace_capacity>> events{
+      std::make_unique<std::array<trace_event, trace_capacity>>()};
+    std::atomic<uint64_t>                                    next{0};
+
+    std::chrono::steady_clock::time_point                    origin{
+      std::chrono::steady_clock::now()};
+
+    std::mutex                                               names_mutex;
+    std::map<uint32_t, std::string>                          names;
+  };
+
+
+
+  [[nodiscard]] uint32_t current_thread() {
+    thread_local const auto id = static_cast<uint32_t>(gettid());
+    return id;
+  }
+}
+
+
+
+namespace { namespace global_state {
+  std::atomic<bool>             enabled{false};
+  std::unique_ptr<trace_buffer> buffer;
+}}
+
+
+
+
+
+void enable_tracing() {
+  global_state::buffer  = std::make_unique<trace_buffer>();
+  global_state::enabled = true;
+
+  trace_thread_name("main");
+}
+
+
+
+bool tracing_enabled() {
+  return global_state::enabled.load(std::memory_order_relaxed);
+}
+
+
+
+void trace_thread_name(std::string_view name) {
+  if (!tracing_enabled()) {
+    return;
+  }
+
+  auto& buffer = *global_state::buffer;
+
+  std::lock_guard lock{buffer.names_mutex};
+  buffer.names[current_thread()] = name;
+}
+
+
+
+
+
+void trace_zone::record(
+    const char*                           name,
+    std::string_view                      detail,
+    std::chrono::steady_clock::time_point begin,
+    std::chrono::steady_clock::time_point end
+) {
+  auto& buffer = *global_state::buffer;
+
+  auto index = buffer.next.fetch_add(1, std::memory_order_relaxed);
+  auto& event = (*buffer.events)[index % trace_capacity];
+
+  auto lap = 2 * (index / trace_capacity);
+  event.sequence.store(lap + 1, std::memory_order_release);
+
+  event.name   = name;
+  event.thread = current_thread();
+  event.begin_ns    = (begin - buffer.origin).count();
+  event.duration_ns = (end - begin).count();
+
+  // keep the end of long paths, it is the more telling part
+  if (detail.size() >= detail_size) {
+    detail = detail.substr(detail.size() - detail_size + 1);
+  }
+  std::ranges::fill(std::ranges::copy(detail, event.detail.begin()).out,
+                    event.detail.end(), 0);
+
+  event.sequence.store(lap + 2, std::memory_order_release);
+}
+
+
+
+
+
+namespace {
+  void write_escaped(std::ostream& out, std::string_view text) {
+    for (char c: text) {
+      switch (c) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            std::array<char, 8> escaped{};
+            std::snprintf(escaped.data(), escaped.size(), "\\u%04x", c);
+            out << escaped.data();
+          } else {
+            out << c;
+          }
+      }
+    }
+  }
+}
+
+
+
+void write_trace(const std::filesystem::path& path) {
+  if (!tracing_enabled()) {
+    return;
+  }
+
+  auto& buffer = *global_state::buffer;
+
+  std::ofstream out{path};
+  if (!out) {
+    throw std::runtime_error{"unable to open trace file \"" + path.string() + "\""};
+  }
+
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+  {
+    std::lock_guard lock{buffer.names_mutex};
+    for (const auto& [thread, name]: buffer.names) {
+      out << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << thread
+          << R"(,"args":{"name":")";
+      write_escaped(out, name);
+      out << "\"}},\n";
+    }
+  }
+
+  auto   end   = buffer.next.load(std::memory_order_acquire);
+  auto   begin = end > trace_capacity ? end - trace_capacity : 0;
+  size_t written{0};
+
+  for (auto index = begin; index < end; ++index) {
+    const auto& event = (*buffer.events)[index % trace_capacity];
+
+    auto sequence = event.sequence.load(std::memory_order_acquire);
+    if (sequence != 2 * (index / trace_capacity) + 2) {
+      // still being written or already overwritten
+      continue;
+    }
+
+    out << R"({"ph":"X","cat":"phodispl","pid":1,"tid":)" << event.thread
+        << R"(,"name":")" << event.name
+        << R"(","ts":)" << event.begin_ns / 1000 << '.'
+        << std::to_string(1000 + event.begin_ns % 1000).substr(1)
+        << R"(,"dur":)" << event.duration_ns / 1000 << '.'
+        << std::to_string(1000 + event.duration_ns % 1000).substr(1);
+
+    if (event.detail[0] != 0) {
+      out << R"(,"args":{"detail":")";
+      write_escaped(out, event.detail.data());
+      out << "\"}";
+    }
+
+    out << "},\n";
+    ++written;
+  }
+
+  // trailing comma is not allowed, an empty metadata event closes the list
+  out << R"({"ph":"M","name":"process_name","pid":1,"args":{"name":"phodispl"}})"
+      << "\n]}\n";
+
+  logcerr::verbose("wrote {} trace event(s) to \"{}\"", written, path.string());
+}
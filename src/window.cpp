@@ -8,6 +8,7 @@
 
 #include <logcerr/log.hpp>
 
+#include <win/frame-statistics.hpp>
 #include <win/modifier.hpp>
 #include <win/widget-constraint.hpp>
 
@@ -44,7 +45,9 @@ window::window(std::vector<std::filesystem::path> sl) :
   },
 
   nav_left_ {true,  [this]() { image_source_.previous_image(); }},
-  nav_right_{false, [this]() { image_source_.next_image();     }}
+  nav_right_{false, [this]() { image_source_.next_image();     }},
+
+  perf_hud_ {[this]() { return perf_sample(); }}
 {
   logcerr::verbose("window backend: {}", win::to_string(backend()));
 
@@ -89,6 +92,29 @@ window::window(std::vector<std::filesystem::path> sl) :
       }
   });
 
+  add_child(&perf_hud_, win::widget_constraint{
+      .width  = win::dimension_compute_constraint{},
+      .height = win::dimension_compute_constraint{},
+      .margin = win::margin_constraint{
+        .start  = 24.f,
+        .end    = {},
+        .top    = {},
+        .bottom = 24.f,
+      }
+  });
+
+  add_child(&listing_progress_, win::widget_constraint{
+      .width  = 24.f,
+      .height = 24.f,
+      .margin = win::margin_constraint{
+        .start  = {},
+        .end    = 24.f,
+        .top    = {},
+        .bottom = 24.f,
+      }
+  });
+  listing_progress_.indeterminate();
+
   application::window().min_size({144, 144});
 }
 
@@ -162,6 +188,14 @@ void window::on_update() {
     image_display_.translate({samp_x, samp_y});
   }
 
+  image_source_.collect_textures();
+
+  if (image_source_.listing()) {
+    listing_progress_.show();
+  } else {
+    listing_progress_.hide();
+  }
+
   update_title();
 }
 
@@ -190,6 +224,30 @@ void window::update_title() {
 
 
 
+perf_hud::sample window::perf_sample() const {
+  using stage = win::frame_statistics::stage;
+
+  const auto& stats = frame_stats();
+
+  perf_hud::sample sample;
+  sample.frame_time     = stats[stage::update].last() + stats[stage::render].last()
+                            + stats[stage::swap].last();
+  sample.frame_interval = stats[stage::interval].last();
+
+  if (auto current = image_source_.current()) {
+    if (auto decode = current->timing().decode; decode.count() > 0) {
+      sample.decode = decode;
+    }
+  }
+
+  sample.status = image_source_.status();
+
+  return sample;
+}
+
+
+
+
 
 void window::on_key_leave() {
   move_x_scale_.deactivate();
@@ -342,6 +400,11 @@ void window::on_key_press(win::key keycode) {
       image_display_.toggle_infobar();
       break;
 
+    case win::key_from_char('p'):
+    case win::key_from_char('P'):
+      perf_hud_.toggle();
+      break;
+
     default:
       break;
   }
@@ -0,0 +1,186 @@
+#include "phodispl/disk-cache.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <source_location>
+#include <thread>
+
+#include <unistd.h>
+
+
+
+namespace {
+  void assert(
+      bool                 expression,
+      std::source_location location = std::source_location::current()
+  ) {
+    if (!expression) {
+      std::cout << "assertion failed: " << location.line() << '\n' << std::flush;
+      exit(1);
+    }
+  }
+
+
+
+  [[nodiscard]] source_frame make_frame(size_t width, size_t height, size_t stride) {
+    auto pixels = std::make_shared<std::vector<std::byte>>(stride * height);
+    for (size_t i = 0; i < pixels->size(); ++i) {
+      (*pixels)[i] = static_cast<std::byte>(i * 7 + width);
+    }
+
+    return source_frame {
+      .pixels = {
+        .data   = *pixels,
+        .width  = width,
+        .height = height,
+        .stride = stride,
+        .format = {
+          .format   = pixglot::data_format::u8,
+          .channels = pixglot::color_channels::rgba
+        },
+        .owner  = pixels
+      },
+      .properties = {
+        .orientation = pixglot::square_isometry::rotate_cw,
+        .source_info = {},
+        .duration    = std::chrono::milliseconds{40}
+      }
+    };
+  }
+
+
+
+  [[nodiscard]] bool same_pixels(const pixel_source& lhs, const pixel_source& rhs) {
+    size_t row_size = lhs.width * pixglot::byte_size(lhs.format);
+
+    for (size_t row = 0; row < lhs.height; ++row) {
+      if (std::memcmp(lhs.data.subspan(row * lhs.stride).data(),
+                      rhs.data.subspan(row * rhs.stride).data(), row_size) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+
+
+  // the only entry in the directory
+  [[nodiscard]] std::filesystem::path entry_in(const std::filesystem::path& directory) {
+    return std::filesystem::directory_iterator{directory}->path();
+  }
+
+
+
+  void patch(const std::filesystem::path& path, size_t offset, uint64_t value) {
+    std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+    file.seekp(static_cast<std::streamoff>(offset));
+    //NOLINTNEXTLINE(*reinterpret-cast)
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+
+
+  // offsets within the entry layout
+  constexpr size_t frame_count_offset{24};
+  constexpr size_t header_size       {32};
+  constexpr size_t stride_offset     {24};
+}
+
+
+
+int main() {
+  auto directory = std::filesystem::temp_directory_path() /
+    ("phodispl-disk-cache-test-" + std::to_string(getpid()));
+
+  auto image_path = directory / "image";
+  std::filesystem::create_directories(directory);
+  std::ofstream{image_path} << "content";
+
+  {
+    disk_cache cache{directory / "cache", 1024 * 1024};
+
+    auto key = disk_cache::key_for(image_path, "options");
+    assert(key.has_value());
+    assert(key != disk_cache::key_for(image_path, "other options"));
+    assert(!disk_cache::key_for(directory / "missing", "options"));
+
+    assert(!cache.lookup(*key));
+
+    // padded rows are stored compactly
+    std::vector<source_frame> frames{make_frame(13, 7, 64), make_frame(5, 3, 20)};
+    cache.store(*key, frames);
+
+    auto cached = cache.lookup(*key);
+    assert(cached.has_value());
+    assert(cached->size() == frames.size());
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+      const auto& lhs = frames[i];
+      const auto& rhs = (*cached)[i];
+
+      assert(lhs.pixels.width  == rhs.pixels.width);
+      assert(lhs.pixels.height == rhs.pixels.height);
+      assert(lhs.pixels.format.format   == rhs.pixels.format.format);
+      assert(lhs.pixels.format.channels == rhs.pixels.format.channels);
+      assert(lhs.properties.orientation == rhs.properties.orientation);
+      assert(lhs.properties.duration    == rhs.properties.duration);
+      assert(same_pixels(lhs.pixels, rhs.pixels));
+    }
+
+    // a modified file no longer matches its entry
+    std::ofstream{image_path} << "changed content";
+    auto changed = disk_cache::key_for(image_path, "options");
+    assert(changed.has_value() && changed != key);
+    assert(!cache.lookup(*changed));
+
+
+
+    // entries used least recently are evicted first
+    disk_cache small{directory / "small", 1024};
+
+    auto first  = make_frame(16, 8, 64);
+    auto second = make_frame(16, 8, 64);
+
+    small.store("first", std::span{&first, 1});
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    small.store("second", std::span{&second, 1});
+    assert(!small.lookup("first"));
+    assert(small.lookup("second").has_value());
+
+
+
+    // corrupt entries are rejected and removed
+    auto frame = make_frame(16, 8, 64);
+
+    disk_cache frame_count{directory / "frame-count", 1024 * 1024};
+    frame_count.store("key", std::span{&frame, 1});
+    patch(entry_in(directory / "frame-count"), frame_count_offset, uint64_t{1} << 60);
+    assert(!frame_count.lookup("key"));
+    assert(std::filesystem::is_empty(directory / "frame-count"));
+
+    disk_cache stride{directory / "stride", 1024 * 1024};
+    stride.store("key", std::span{&frame, 1});
+    patch(entry_in(directory / "stride"), header_size + 3 + stride_offset, 1);
+    assert(!stride.lookup("key"));
+    assert(std::filesystem::is_empty(directory / "stride"));
+
+
+
+    // concurrent stores of the same entry do not interfere
+    disk_cache shared{directory / "shared", 1024 * 1024};
+    {
+      std::vector<std::jthread> writers;
+      for (size_t i = 0; i < 8; ++i) {
+        writers.emplace_back([&shared, &frame]() {
+          shared.store("key", std::span{&frame, 1});
+        });
+      }
+    }
+    auto stored = shared.lookup("key");
+    assert(stored.has_value() && same_pixels(stored->front().pixels, frame.pixels));
+  }
+
+  std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,128 @@
+#include "phodispl/event-coalescer.hpp"
+#include "phodispl/statistics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <source_location>
+#include <thread>
+#include <vector>
+
+
+
+namespace {
+  void assert(
+      bool                 expression,
+      std::source_location location = std::source_location::current()
+  ) {
+    if (!expression) {
+      std::cout << "assertion failed: " << location.line() << '\n' << std::flush;
+      exit(1);
+    }
+  }
+
+
+
+  using action = fs_watcher::action;
+  using clock  = std::chrono::steady_clock;
+
+  constexpr std::chrono::milliseconds quiet{50};
+
+
+
+  class receiver {
+    public:
+      void receive(std::vector<fs_watcher::event> batch) {
+        {
+          std::lock_guard lock{mutex_};
+          batches_.emplace_back(std::move(batch));
+          times_.emplace_back(clock::now());
+        }
+        cv_.notify_all();
+      }
+
+      [[nodiscard]] bool wait_for(size_t count) {
+        std::unique_lock lock{mutex_};
+        return cv_.wait_for(lock, std::chrono::seconds{10},
+            [this, count]() { return batches_.size() >= count; });
+      }
+
+      [[nodiscard]] std::vector<fs_watcher::event> batch(size_t index) {
+        std::lock_guard lock{mutex_};
+        auto batch = batches_.at(index);
+        std::ranges::sort(batch);
+        return batch;
+      }
+
+      [[nodiscard]] clock::time_point time(size_t index) {
+        std::lock_guard lock{mutex_};
+        return times_.at(index);
+      }
+
+    private:
+      std::mutex                                  mutex_;
+      std::condition_variable                     cv_;
+      std::vector<std::vector<fs_watcher::event>> batches_;
+      std::vector<clock::time_point>              times_;
+  };
+
+
+
+  void test_merge() {
+    receiver rec;
+    event_coalescer coalescer{std::bind_front(&receiver::receive, &rec), quiet};
+
+    auto before = global_statistics().suppressed_fs_events.load();
+
+    coalescer.push("a", action::added);
+    coalescer.push("b", action::added);
+    coalescer.push("c", action::removed);
+    coalescer.push("a", action::changed);
+    coalescer.push("b", action::removed);
+    coalescer.push("c", action::added);
+    coalescer.push("d", action::changed);
+    coalescer.push("a", action::changed);
+
+    assert(rec.wait_for(1));
+
+    std::vector<fs_watcher::event> expected {
+      {"a", action::added},
+      {"c", action::changed},
+      {"d", action::changed},
+    };
+    assert(rec.batch(0) == expected);
+
+    assert(global_statistics().suppressed_fs_events.load() - before == 5);
+  }
+
+
+
+  void test_quiet_period() {
+    receiver rec;
+    event_coalescer coalescer{std::bind_front(&receiver::receive, &rec), quiet};
+
+    auto last = clock::now();
+    for (size_t i = 0; i < 10; ++i) {
+      last = clock::now();
+      coalescer.push("a", action::changed);
+      std::this_thread::sleep_for(quiet / 5);
+    }
+
+    assert(rec.wait_for(1));
+    assert(rec.time(0) - last >= quiet);
+
+    std::vector<fs_watcher::event> expected {{"a", action::changed}};
+    assert(rec.batch(0) == expected);
+  }
+}
+
+
+
+int main() {
+  test_merge();
+  test_quiet_period();
+
+  return 0;
+}
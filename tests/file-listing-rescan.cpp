@@ -0,0 +1,109 @@
+#include "phodispl/config.hpp"
+#include "phodispl/file-listing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <source_location>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+
+
+namespace {
+  void assert(
+      bool                 expression,
+      std::source_location location = std::source_location::current()
+  ) {
+    if (!expression) {
+      std::cout << "assertion failed: " << location.line() << '\n' << std::flush;
+      exit(1);
+    }
+  }
+
+
+
+  using action = fs_watcher::action;
+
+  void create_old_file(const std::filesystem::path& path) {
+    std::ofstream{path} << "content";
+    std::filesystem::last_write_time(path,
+        std::filesystem::file_time_type::clock::now() - std::chrono::hours{1});
+  }
+}
+
+
+
+int main() {
+  auto cfg = global_config();
+  cfg.watch_fs      = false;
+  cfg.fl_single_dir = listing_mode::always;
+  set_global_config(std::move(cfg));
+
+  auto directory = std::filesystem::temp_directory_path() /
+    ("phodispl-file-listing-rescan-" + std::to_string(getpid()));
+  std::filesystem::create_directories(directory);
+
+  for (const auto* name: {"a", "b", "c", "d"}) {
+    create_old_file(directory / name);
+  }
+
+  std::vector<fs_watcher::event> reported;
+
+  {
+    file_listing listing{[&reported](std::vector<fs_watcher::event> events) {
+      reported.insert(reported.end(), events.begin(), events.end());
+    }, {directory}};
+
+    assert(listing.populate().size() == 4);
+
+    listing.rescan();
+    assert(reported.empty());
+
+    std::filesystem::remove(directory / "b");
+    std::ofstream{directory / "c"} << "changed content";
+    std::ofstream{directory / "e"} << "new content";
+
+    listing.rescan();
+    std::ranges::sort(reported);
+
+    std::vector<fs_watcher::event> expected {
+      {directory / "b", action::removed},
+      {directory / "c", action::changed},
+      {directory / "e", action::added},
+    };
+    assert(reported == expected);
+  }
+
+  // changes found while populating are reported once the listing is complete
+  reported.clear();
+
+  {
+    bool reported_early{false};
+
+    file_listing listing{[&reported](std::vector<fs_watcher::event> events) {
+      reported.insert(reported.end(), events.begin(), events.end());
+    }, {directory}};
+
+    auto list = listing.populate({}, [&](std::vector<std::filesystem::path> /*batch*/) {
+      std::filesystem::remove(directory / "a");
+      listing.rescan();
+      reported_early = !reported.empty();
+    });
+
+    assert(!reported_early);
+    // a, c, d and e
+    assert(list.size() == 4);
+
+    // recently written files may be reported as changed as well
+    fs_watcher::event removal{directory / "a", action::removed};
+    assert(std::ranges::count(reported, removal) == 1);
+  }
+
+  std::filesystem::remove_all(directory);
+
+  return 0;
+}
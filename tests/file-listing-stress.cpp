@@ -0,0 +1,182 @@
+#include "phodispl/config.hpp"
+#include "phodispl/file-listing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+
+
+namespace {
+  void assert(
+      bool                 expression,
+      std::source_location location = std::source_location::current()
+  ) {
+    if (!expression) {
+      std::cout << "assertion failed: " << location.line() << '\n' << std::flush;
+      exit(1);
+    }
+  }
+
+
+
+  using clock = std::chrono::steady_clock;
+
+  constexpr size_t file_count {100'000};
+  constexpr size_t event_count{10'000};
+
+  // the small run uses a tenth of the files, everything else has to scale accordingly
+  constexpr size_t scale{10};
+
+
+
+  [[nodiscard]] size_t max_user_watches() {
+    std::ifstream input{"/proc/sys/fs/inotify/max_user_watches"};
+    size_t count{0};
+    input >> count;
+    return count;
+  }
+
+
+
+  [[nodiscard]] std::string file_name(size_t index) {
+    return "image-" + std::to_string(index);
+  }
+
+
+
+  class event_counter {
+    public:
+      void count() {
+        {
+          std::lock_guard lock{mutex_};
+          count_++;
+        }
+        cv_.notify_all();
+      }
+
+      [[nodiscard]] bool wait_for(size_t count) {
+        std::unique_lock lock{mutex_};
+        return cv_.wait_for(lock, std::chrono::seconds{60},
+            [this, count]() { return count_ >= count; });
+      }
+
+    private:
+      std::mutex              mutex_;
+      std::condition_variable cv_;
+      size_t                  count_{0};
+  };
+
+
+
+  struct measurement {
+    clock::duration setup;
+    clock::duration burst;
+    size_t          events;
+  };
+
+
+
+  [[nodiscard]] measurement run(const std::filesystem::path& directory, size_t files) {
+    std::filesystem::create_directories(directory);
+    for (size_t i = 0; i < files; ++i) {
+      std::ofstream{directory / file_name(i)};
+    }
+
+    event_counter changes;
+
+    measurement result{};
+
+    {
+      file_listing listing{[&changes](std::vector<fs_watcher::event> events) {
+        for (const auto& [path, act]: events) {
+          if (act == fs_watcher::action::changed) {
+            changes.count();
+          }
+        }
+      }, {directory}};
+
+      auto start = clock::now();
+      auto list  = listing.populate();
+      result.setup = clock::now() - start;
+
+      assert(list.size() == files);
+
+      // closing a file after writing it is reported once per file
+      result.events = std::min(event_count, files);
+
+      start = clock::now();
+      for (size_t i = 0; i < result.events; ++i) {
+        std::ofstream{directory / file_name(i * files / result.events)} << 'x';
+      }
+      assert(changes.wait_for(result.events));
+      result.burst = clock::now() - start;
+    }
+
+    std::filesystem::remove_all(directory);
+
+    std::cout << files << " file(s): watched in "
+      << std::chrono::duration_cast<std::chrono::milliseconds>(result.setup).count()
+      << " ms, " << result.events << " event(s) handled in "
+      << std::chrono::duration_cast<std::chrono::milliseconds>(result.burst).count()
+      << " ms\n";
+
+    return result;
+  }
+
+
+
+  // a quadratic cost would grow by scale², allow a generous constant on top of scale
+  [[nodiscard]] bool grows_linearly(
+      clock::duration small,
+      clock::duration large,
+      size_t          factor
+  ) {
+    return large <= 4 * factor * small + std::chrono::milliseconds{250};
+  }
+
+
+
+  void test_scaling(watch_granularity granularity, size_t files) {
+    auto cfg = global_config();
+    cfg.watch_fs             = true;
+    cfg.watch_fs_granularity = granularity;
+    cfg.fl_single_dir        = listing_mode::always;
+    set_global_config(std::move(cfg));
+
+    auto directory = std::filesystem::temp_directory_path() /
+      ("phodispl-file-listing-stress-" + std::to_string(getpid()));
+
+    auto small = run(directory, files / scale);
+    auto large = run(directory, files);
+
+    assert(grows_linearly(small.setup, large.setup, scale));
+    auto expected_burst = small.burst * large.events / small.events;
+    assert(grows_linearly(expected_burst, large.burst, 1));
+  }
+}
+
+
+
+int main() {
+  std::cout << "watching directories\n";
+  test_scaling(watch_granularity::directories, file_count);
+
+  // every file needs a watch of its own
+  if (auto files = std::min(file_count, max_user_watches() / 2); files >= scale * 1000) {
+    std::cout << "watching files\n";
+    test_scaling(watch_granularity::files, files);
+  } else {
+    std::cout << "not enough inotify watches available to watch files\n";
+  }
+
+  return 0;
+}
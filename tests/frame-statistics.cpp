@@ -0,0 +1,66 @@
+#include <win/frame-statistics.hpp>
+
+#include <iostream>
+#include <source_location>
+
+
+
+namespace {
+  void assert(
+      bool                 expression,
+      std::source_location location = std::source_location::current()
+  ) {
+    if (!expression) {
+      std::cout << "assertion failed: " << location.line() << '\n' << std::flush;
+      exit(1);
+    }
+  }
+}
+
+
+
+int main() {
+  using namespace std::chrono_literals;
+  using stage = win::frame_statistics::stage;
+
+  win::frame_statistics::histogram hist;
+  assert(hist.count() == 0);
+  assert(hist.mean() == 0ms);
+  assert(hist.percentile(0.5f) == 0ms);
+
+  for (int i = 1; i <= 100; ++i) {
+    hist.add(std::chrono::milliseconds{i});
+  }
+  hist.add(1s);
+
+  assert(hist.count() == 101);
+  assert(hist.max()   == 1s);
+  assert(hist.last()  == 1s);
+  assert(hist.percentile(0.f)   == 1250us);
+  assert(hist.percentile(0.25f) == 26250us);
+  // beyond the last bucket
+  assert(hist.percentile(0.99f) == 1s);
+  assert(hist.percentile(1.f)   == 1s);
+
+
+
+  win::frame_statistics stats;
+  stats.budget(10ms);
+
+  auto now = win::frame_statistics::clock::now();
+
+  stats.frame_callback(now);
+  stats.frame(1ms, 2ms, 3ms);
+  stats.frame_callback(now + 16ms);
+  stats.frame(5ms, 6ms, 1ms);
+  stats.frame_callback(now + 33ms);
+  // idle, no frame rendered
+  stats.frame_callback(now + 1s);
+
+  assert(stats[stage::render].count() == 2);
+  assert(stats[stage::swap].last() == 1ms);
+  assert(stats.missed_frames() == 1);
+
+  assert(stats[stage::interval].count() == 2);
+  assert(stats[stage::interval].max() == 17ms);
+}
@@ -0,0 +1,102 @@
+#include <indexed-heap.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <source_location>
+
+
+
+
+namespace {
+  void assert(
+      bool                 expression,
+      std::source_location location = std::source_location::current()
+  ) {
+    if (!expression) {
+      std::cout << "assertion failed: " << location.line() << '\n' << std::flush;
+      exit(1);
+    }
+  }
+
+
+
+  void test_against_reference(size_t key_count, size_t operations) {
+    std::mt19937_64 rng{key_count};
+    std::uniform_int_distribution<int> key_dist{0, static_cast<int>(key_count) - 1};
+    std::uniform_int_distribution<int> prio_dist{-100, 100};
+    std::uniform_int_distribution<int> op_dist{0, 3};
+
+    indexed_heap<int, int> heap;
+    std::map<int, int>     reference;
+
+    for (size_t i = 0; i < operations; ++i) {
+      switch (op_dist(rng)) {
+        case 0:
+        case 1: {
+          auto key  = key_dist(rng);
+          auto prio = prio_dist(rng);
+
+          auto it = reference.find(key);
+          bool changed = it == reference.end() || it->second != prio;
+          assert(heap.set(key, prio) == changed);
+          reference[key] = prio;
+        } break;
+
+        case 2: {
+          auto key = key_dist(rng);
+          assert(heap.erase(key) == (reference.erase(key) > 0));
+        } break;
+
+        case 3:
+          if (!reference.empty()) {
+            auto min = std::ranges::min_element(reference, {},
+                [](const auto& pair) { return pair.second; })->second;
+
+            auto [prio, key] = heap.pop();
+            assert(prio == min);
+            assert(reference.at(key) == prio);
+            reference.erase(key);
+          }
+          break;
+      }
+
+      assert(heap.size() == reference.size());
+    }
+
+    for (const auto& [key, prio]: reference) {
+      assert(heap.contains(key));
+      assert(heap.priority(key) == prio);
+    }
+
+    int last = std::numeric_limits<int>::min();
+    while (!heap.empty()) {
+      auto [prio, key] = heap.pop();
+      assert(prio >= last);
+      assert(!heap.contains(key));
+      last = prio;
+    }
+  }
+}
+
+
+
+int main() {
+  test_against_reference(1,    100);
+  test_against_reference(10,   10000);
+  test_against_reference(1000, 100000);
+
+
+  indexed_heap<int, int> heap;
+  assert(heap.set(1, 5));
+  assert(heap.set(2, 3));
+  assert(!heap.set(2, 3));
+  assert(heap.set(1, 1));
+  assert(heap.top().second == 1);
+  assert(heap.erase(1));
+  assert(!heap.erase(1));
+  assert(heap.pop().second == 2);
+  assert(heap.empty());
+}
@@ -0,0 +1,69 @@
+#include "phodispl/navigation-predictor.hpp"
+
+#include <iostream>
+#include <source_location>
+
+
+
+
+namespace {
+  void assert(
+      bool                 expression,
+      std::source_location location = std::source_location::current()
+  ) {
+    if (!expression) {
+      std::cout << "assertion failed: " << location.line() << '\n' << std::flush;
+      exit(1);
+    }
+  }
+
+
+
+  using clock = navigation_predictor::clock;
+  using namespace std::chrono_literals;
+}
+
+
+
+int main() {
+  const neighbor_window base{2, 1};
+  auto now = clock::now();
+
+
+  navigation_predictor idle;
+  assert(idle.velocity(now) == 0.f);
+  assert(idle.predict(base, true, now) == base);
+  assert(!idle.expiry());
+
+
+  navigation_predictor single;
+  single.record(1, now);
+  assert(single.predict(base, true, now + 10ms) == base);
+
+
+  navigation_predictor forward;
+  for (int i = 0; i < 10; ++i) {
+    forward.record(1, now + i * 40ms);
+  }
+  auto t = now + 9 * 40ms;
+
+  assert(forward.velocity(t) > 20.f && forward.velocity(t) < 30.f);
+
+  auto win = forward.predict(base, true, t);
+  assert(win.backward == 0);
+  assert(win.forward > base.forward + base.backward);
+  assert(forward.predict(base, false, t) == (neighbor_window{3, 0}));
+
+  auto expiry = forward.expiry();
+  assert(expiry && *expiry > t && *expiry < t + 1s);
+  assert(forward.predict(base, true, *expiry + 1ms) == base);
+
+  assert(forward.velocity(t + 1s) == 0.f);
+  assert(forward.predict(base, true, t + 1s) == base);
+
+
+  forward.record(-1, t + 40ms);
+  forward.record(-1, t + 80ms);
+  assert(forward.velocity(t + 80ms) < 0.f);
+  assert(forward.predict(base, false, t + 80ms) == (neighbor_window{0, 3}));
+}
@@ -0,0 +1,138 @@
+#include <order-statistic-tree.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <source_location>
+#include <vector>
+
+
+
+
+namespace {
+  void assert(
+      bool                 expression,
+      std::source_location location = std::source_location::current()
+  ) {
+    if (!expression) {
+      std::cout << "assertion failed: " << location.line() << '\n' << std::flush;
+      exit(1);
+    }
+  }
+
+
+
+  [[nodiscard]] std::vector<int> contents(const order_statistic_tree<int>& tree) {
+    std::vector<int> values;
+    tree.for_each([&values](int v) { values.emplace_back(v); });
+    return values;
+  }
+
+
+
+  void test_against_reference(size_t operations) {
+    std::mt19937_64 rng{operations};
+    std::uniform_int_distribution<int> op_dist{0, 3};
+
+    order_statistic_tree<int> tree;
+    std::vector<int>          reference;
+
+    for (size_t i = 0; i < operations; ++i) {
+      auto index = [&](size_t extra) {
+        return std::uniform_int_distribution<size_t>{0, reference.size() - 1 + extra}(rng);
+      };
+
+      switch (op_dist(rng)) {
+        case 0:
+        case 1: {
+          auto pos = reference.empty() ? 0 : index(1);
+          tree.insert(pos, static_cast<int>(i));
+          reference.insert(reference.begin() + pos, static_cast<int>(i));
+        } break;
+
+        case 2:
+          if (!reference.empty()) {
+            auto pos = index(0);
+            assert(tree.erase(pos) == reference[pos]);
+            reference.erase(reference.begin() + pos);
+          }
+          break;
+
+        default:
+          if (!reference.empty()) {
+            auto pos = index(0);
+            assert(tree[pos] == reference[pos]);
+          }
+          break;
+      }
+
+      assert(tree.size() == reference.size());
+    }
+
+    assert(contents(tree) == reference);
+  }
+
+
+
+  void test_assign_and_search() {
+    std::vector<int> sorted;
+    for (int i = 0; i < 10'000; ++i) {
+      sorted.emplace_back(2 * i);
+    }
+
+    order_statistic_tree<int> tree;
+    tree.assign(sorted);
+
+    assert(tree.size() == sorted.size());
+    assert(contents(tree) == sorted);
+
+    for (int v: {-1, 0, 1, 2, 5'001, 19'998, 19'999, 20'000}) {
+      auto expected = std::ranges::lower_bound(sorted, v) - sorted.begin();
+      assert(tree.partition_point([v](int x) { return x < v; })
+             == static_cast<size_t>(expected));
+    }
+
+    tree[5] = -1;
+    assert(tree[5] == -1);
+
+    auto released = tree.release();
+    assert(tree.empty());
+    assert(released.size() == sorted.size());
+    assert(released[5] == -1 && released[6] == sorted[6]);
+
+    tree.assign({});
+    assert(tree.empty());
+  }
+
+
+
+  // inserting into a sorted sequence must not degrade to linear time
+  void test_scaling() {
+    order_statistic_tree<int> tree;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 200'000; ++i) {
+      tree.insert(tree.size() / 2, i);
+    }
+    for (int i = 0; i < 100'000; ++i) {
+      [[maybe_unused]] auto v = tree.erase(tree.size() / 3);
+    }
+    auto time = std::chrono::steady_clock::now() - start;
+
+    assert(tree.size() == 100'000);
+    assert(time < std::chrono::seconds{5});
+  }
+}
+
+
+
+int main() {
+  test_against_reference(10);
+  test_against_reference(1'000);
+  test_against_reference(100'000);
+
+  test_assign_and_search();
+
+  test_scaling();
+}
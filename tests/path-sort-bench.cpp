@@ -0,0 +1,136 @@
+#include "phodispl/path-compare.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+
+// Compares sorting a directory listing and looking up added files with the semantic
+// comparison against the precomputed sort keys.
+
+namespace {
+  using clock = std::chrono::steady_clock;
+
+
+
+  [[nodiscard]] std::vector<std::filesystem::path> listing(size_t count) {
+    std::mt19937_64 rng{count};
+    std::uniform_int_distribution<size_t> number{0, 99'999};
+    std::uniform_int_distribution<size_t> style {0, 3};
+
+    std::vector<std::filesystem::path> paths;
+    paths.reserve(count);
+
+    for (size_t i = 0; i < count; ++i) {
+      auto n = std::to_string(number(rng));
+
+      std::string name;
+      switch (style(rng)) {
+        case 0:  name = "IMG_" + n + ".JPG";           break;
+        case 1:  name = "holiday 2023 (" + n + ").jpg"; break;
+        case 2:  name = "scan-" + n + "-v2.png";        break;
+        default: name = "DSC" + n + ".nef";             break;
+      }
+
+      paths.emplace_back("/home/user/pictures/" + name);
+    }
+
+    return paths;
+  }
+
+
+
+  [[nodiscard]] double ms(clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  }
+
+
+
+  struct result {
+    double sort;
+    double lookup;
+    size_t positions;
+  };
+
+
+
+  [[nodiscard]] result run_compare(std::vector<std::filesystem::path> paths,
+                                   const std::vector<std::filesystem::path>& queries) {
+    path_compare compare{path_compare_method::semantic};
+
+    auto start = clock::now();
+    std::ranges::sort(paths, compare);
+    auto sorted = clock::now();
+
+    // sum of the insertion positions, which must agree between both orderings
+    size_t positions{0};
+    for (const auto& q: queries) {
+      auto it = std::ranges::lower_bound(paths, q, compare);
+      positions += it - paths.begin();
+    }
+
+    return {ms(sorted - start), ms(clock::now() - sorted), positions};
+  }
+
+
+
+  [[nodiscard]] result run_keys(const std::vector<std::filesystem::path>& paths,
+                                const std::vector<std::filesystem::path>& queries) {
+    path_compare compare{path_compare_method::semantic};
+
+    auto start = clock::now();
+
+    std::vector<std::string> keys;
+    keys.reserve(paths.size());
+    for (const auto& p: paths) {
+      keys.emplace_back(compare.key(p));
+    }
+    std::ranges::sort(keys);
+
+    auto sorted = clock::now();
+
+    // sum of the insertion positions, which must agree between both orderings
+    size_t positions{0};
+    for (const auto& q: queries) {
+      auto it = std::ranges::lower_bound(keys, compare.key(q));
+      positions += it - keys.begin();
+    }
+
+    return {ms(sorted - start), ms(clock::now() - sorted), positions};
+  }
+}
+
+
+
+int main() {
+  std::cout << std::setw(10) << "files"
+            << std::setw(20) << "compare sort [ms]"
+            << std::setw(20) << "key sort [ms]"
+            << std::setw(20) << "compare find [ms]"
+            << std::setw(20) << "key find [ms]" << '\n';
+
+  for (size_t count: {1'000, 10'000, 100'000}) {
+    auto paths   = listing(count);
+    auto queries = listing(1'000);
+
+    auto cmp  = run_compare(paths, queries);
+    auto keys = run_keys(paths, queries);
+
+    if (cmp.positions != keys.positions) {
+      std::cout << "orderings disagree\n";
+      return 1;
+    }
+
+    std::cout << std::setw(10) << count << std::fixed << std::setprecision(2)
+              << std::setw(20) << cmp.sort
+              << std::setw(20) << keys.sort
+              << std::setw(20) << cmp.lookup
+              << std::setw(20) << keys.lookup << '\n';
+  }
+}
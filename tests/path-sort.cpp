@@ -1,11 +1,13 @@
 #include "phodispl/path-compare.hpp"
 
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <filesystem>
 #include <random>
 #include <source_location>
 #include <span>
+#include <string>
 #include <vector>
 
 
@@ -56,6 +58,55 @@ namespace {
       }
     }
   }
+
+
+
+  [[nodiscard]] std::vector<std::filesystem::path> random_paths(size_t count) {
+    static constexpr std::array<std::string_view, 16> pieces {
+      "a", "b", "A", "B", "0", "1", "9", "00", ".", "/", "-", "_", " ", "é", "Ä", "z"
+    };
+
+    std::mt19937_64 rng{count};
+    std::uniform_int_distribution<size_t> length{0, 8};
+    std::uniform_int_distribution<size_t> piece{0, pieces.size() - 1};
+
+    std::vector<std::filesystem::path> paths;
+    paths.reserve(count);
+
+    for (size_t i = 0; i < count; ++i) {
+      std::string str;
+      for (size_t l = length(rng); l > 0; --l) {
+        str += pieces[piece(rng)];
+      }
+      paths.emplace_back(std::move(str));
+    }
+
+    return paths;
+  }
+
+
+
+  // the order of the sort keys must agree with the comparison for every pair
+  void test_keys(path_compare_method mode, std::span<const std::filesystem::path> paths) {
+    path_compare compare{mode};
+
+    std::vector<std::string> keys;
+    keys.reserve(paths.size());
+    for (const auto& p: paths) {
+      keys.emplace_back(compare.key(p));
+    }
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+      for (size_t j = 0; j < paths.size(); ++j) {
+        if (compare(paths[i], paths[j]) != (keys[i] < keys[j])) {
+          std::cout << "mode: " << stringify(mode) << '\n'
+                    << "keys disagree for " << paths[i] << " and " << paths[j] << '\n'
+                    << std::flush;
+          exit(1);
+        }
+      }
+    }
+  }
 }
 
 
@@ -78,4 +129,23 @@ int main() {
 
 
   assert(semantic_compare("earth", "electron"));
+
+  // a path running out of words first sorts first, regardless of the total length
+  assert(semantic_compare("ab", "ab1"));
+  assert(!semantic_compare("ab1", "ab"));
+
+
+  test_keys(path_compare_method::lexicographic, config_source);
+  test_keys(path_compare_method::semantic,      config_source);
+
+  auto paths = random_paths(1500);
+  test_keys(path_compare_method::lexicographic, paths);
+  test_keys(path_compare_method::semantic,      paths);
+
+  std::vector<std::filesystem::path> mixed{
+    "/home/a.png", "/home/a/b.png", "home/a.png", "/home/", "/home", "/", "",
+    "/home/img007.png", "/home/img10.png", "/home/IMG7.png", "/home/img7.png"
+  };
+  test_keys(path_compare_method::lexicographic, mixed);
+  test_keys(path_compare_method::semantic,      mixed);
 }
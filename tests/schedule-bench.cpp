@@ -0,0 +1,125 @@
+#include <indexed-heap.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+
+// Replays the scheduling pattern of image_source (schedule with priority bumps,
+// re-prioritize, unschedule) for a given number of pending entries.
+
+namespace {
+  struct dummy_image {};
+
+  using shared_image = std::shared_ptr<dummy_image>;
+
+
+
+  class sorted_vector_schedule {
+    public:
+      void schedule(const shared_image& img, size_t priority) {
+        if (priority == 0) {
+          for (auto& [prio, _]: images_) {
+            ++prio;
+          }
+        }
+
+        auto it = std::ranges::find(images_, img, &entry::second);
+        if (it == images_.end()) {
+          images_.emplace_back(priority, img);
+        } else if (it->first != priority) {
+          it->first = priority;
+        } else {
+          return;
+        }
+
+        std::ranges::sort(images_, std::ranges::greater(), &entry::first);
+      }
+
+      void unschedule(const shared_image& img) {
+        if (auto it = std::ranges::find(images_, img, &entry::second);
+            it != images_.end()) {
+          images_.erase(it);
+        }
+      }
+
+    private:
+      using entry = std::pair<size_t, shared_image>;
+      std::vector<entry> images_;
+  };
+
+
+
+  class heap_schedule {
+    public:
+      void schedule(const shared_image& img, size_t priority) {
+        if (priority == 0) {
+          ++offset_;
+        }
+        images_.set(img, static_cast<std::ptrdiff_t>(priority) - offset_);
+      }
+
+      void unschedule(const shared_image& img) {
+        images_.erase(img);
+      }
+
+    private:
+      indexed_heap<shared_image, std::ptrdiff_t> images_;
+      std::ptrdiff_t                             offset_{0};
+  };
+
+
+
+  template<typename Schedule>
+  [[nodiscard]] double run(size_t pending, size_t rounds) {
+    std::vector<shared_image> images;
+    images.reserve(pending);
+    for (size_t i = 0; i < pending; ++i) {
+      images.emplace_back(std::make_shared<dummy_image>());
+    }
+
+    Schedule schedule;
+    for (size_t i = 0; i < pending; ++i) {
+      schedule.schedule(images[i], i + 1);
+    }
+
+    std::mt19937_64 rng{pending};
+    std::uniform_int_distribution<size_t> index{0, pending - 1};
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < rounds; ++i) {
+      const auto& img = images[index(rng)];
+      schedule.unschedule(img);
+      schedule.schedule(img, i % 4 == 0 ? 0 : index(rng) + 1);
+    }
+
+    std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+
+    return time.count() / static_cast<double>(rounds);
+  }
+}
+
+
+
+int main() {
+  std::cout << std::setw(10) << "pending"
+            << std::setw(20) << "sorted vector [ns]"
+            << std::setw(20) << "indexed heap [ns]" << '\n';
+
+  for (size_t pending: {10, 100, 1000}) {
+    size_t rounds = 1'000'000 / pending;
+
+    std::cout << std::setw(10) << pending
+              << std::setw(20) << std::fixed << std::setprecision(1)
+              << run<sorted_vector_schedule>(pending, rounds)
+              << std::setw(20)
+              << run<heap_schedule>(pending, rounds) << '\n';
+  }
+}
@@ -0,0 +1,106 @@
+#include "phodispl/config.hpp"
+#include "phodispl/image.hpp"
+#include "phodispl/texture-pool.hpp"
+#include "phodispl/texture-uploader.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <source_location>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include <win/context-wayland.hpp>
+#include <win/context.hpp>
+#include <win/headless-egl.hpp>
+
+
+
+namespace {
+  void assert(
+      bool                 expression,
+      std::source_location location = std::source_location::current()
+  ) {
+    if (!expression) {
+      std::cout << "assertion failed: " << location.line() << '\n' << std::flush;
+      exit(1);
+    }
+  }
+
+
+
+  // meson treats this exit code as a skipped test
+  constexpr int skipped{77};
+
+  constexpr size_t width {300};
+  constexpr size_t height{100};
+  constexpr size_t limit {128};
+
+
+
+  void write_ppm(const std::filesystem::path& path) {
+    std::ofstream out{path, std::ios::binary};
+    out << "P6\n" << width << ' ' << height << "\n255\n";
+    for (size_t i = 0; i < width * height; ++i) {
+      out.put(static_cast<char>(i % 256)).put(static_cast<char>(i / 256 % 256)).put('\0');
+    }
+  }
+}
+
+
+
+int main() {
+  // without a 4.5 context, the uploader cannot be tested either
+  std::optional<win::headless_egl>    egl;
+  std::optional<win::context_wayland> main_context;
+  try {
+    egl.emplace();
+    main_context.emplace(egl->create_context());
+  } catch (std::exception& ex) {
+    std::cout << "no headless egl available: " << ex.what() << '\n';
+    return skipped;
+  }
+
+  auto cfg = global_config();
+  cfg.il_tile_threshold = limit;
+  set_global_config(std::move(cfg));
+
+  auto path = std::filesystem::temp_directory_path() /
+    ("phodispl-tiling-fallback-" + std::to_string(getpid()) + ".ppm");
+  write_ppm(path);
+
+  main_context->bind();
+
+  auto pool = std::make_shared<texture_pool>(0);
+
+  {
+    texture_uploader uploader{win::context{
+        std::make_unique<win::context_wayland>(egl->create_context(*main_context))}, pool};
+
+    // too large for a single texture, decoding directly has to start over with tiles
+    auto img = image::create(path);
+    img->load(uploader, 3, true);
+
+    auto start = std::chrono::steady_clock::now();
+    while (!img->finished()) {
+      assert(std::chrono::steady_clock::now() - start < std::chrono::seconds{10});
+      pool->collect();
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    assert(img->error() == nullptr);
+
+    auto frame = img->current_frame();
+    assert(frame != nullptr);
+    assert(frame->tiled());
+    assert(frame->width() == width && frame->height() == height);
+  }
+
+  pool->collect();
+  std::filesystem::remove(path);
+
+  return 0;
+}
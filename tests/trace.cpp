@@ -0,0 +1,90 @@
+#include "phodispl/trace.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <source_location>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+
+
+namespace {
+  void assert(
+      bool                 expression,
+      std::source_location location = std::source_location::current()
+  ) {
+    if (!expression) {
+      std::cout << "assertion failed: " << location.line() << '\n' << std::flush;
+      exit(1);
+    }
+  }
+
+
+
+  [[nodiscard]] size_t count(const std::string& text, std::string_view pattern) {
+    size_t n{0};
+    for (auto pos = text.find(pattern); pos != std::string::npos;
+         pos = text.find(pattern, pos + 1)) {
+      ++n;
+    }
+    return n;
+  }
+
+
+
+  [[nodiscard]] std::string read_trace(const std::filesystem::path& path) {
+    write_trace(path);
+
+    std::ifstream input{path};
+    return {std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+  }
+
+
+
+  void record(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      trace_zone zone{"zone", "some \"quoted\" detail"};
+    }
+  }
+}
+
+
+
+int main() {
+  auto path = std::filesystem::temp_directory_path() /
+    ("phodispl-trace-test-" + std::to_string(getpid()) + ".json");
+
+  // nothing is recorded before tracing is enabled
+  record(10);
+  assert(!tracing_enabled());
+
+  enable_tracing();
+
+  {
+    std::vector<std::jthread> threads;
+    for (size_t i = 0; i < 4; ++i) {
+      threads.emplace_back([i]() {
+        trace_thread_name("worker" + std::to_string(i));
+        record(1000);
+      });
+    }
+  }
+
+  auto trace = read_trace(path);
+  assert(count(trace, R"("ph":"X")") == 4000);
+  assert(count(trace, R"("name":"thread_name")") == 5);
+  assert(count(trace, R"(some \"quoted\" detail)") == 4000);
+  assert(trace.ends_with("]}\n"));
+
+  // a full buffer keeps the most recent events
+  record(100000);
+  trace = read_trace(path);
+  assert(count(trace, R"("ph":"X")") == 1 << 16);
+
+  std::filesystem::remove(path);
+}